@@ -10,6 +10,7 @@
 #include "sleeplock.h"
 #include "fs.h"
 #include "file.h"
+#include "dev.h"
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
@@ -233,7 +234,7 @@ consoleintr(int (*getc)(void))
 }
 
 int
-consoleread(struct inode *ip, char *dst, int n)
+consoleread(struct inode *ip, char *dst, int n, uint off)
 {
   uint target;
   int c;
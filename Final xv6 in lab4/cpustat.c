@@ -0,0 +1,13 @@
+// Report how long each CPU has spent halted with nothing to
+// run, and how many timer interrupts it has taken.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+int
+main(void)
+{
+  cpus_info();
+  exit();
+}
@@ -0,0 +1,45 @@
+// Bounce a byte between two processes over a pair of pipes.
+// Each round trip is at least two context switches.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+
+#define N 2000
+
+int
+main(void)
+{
+  int ping[2], pong[2], i;
+  uint64 start;
+  uint us;
+  char c;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    printf(1, "ctxbench: pipe failed\n");
+    exit();
+  }
+  if(fork() == 0){
+    for(i = 0; i < N; i++){
+      if(read(ping[0], &c, 1) != 1)
+        break;
+      write(pong[1], &c, 1);
+    }
+    exit();
+  }
+
+  start = nsec();
+  for(i = 0; i < N; i++){
+    write(ping[1], "x", 1);
+    if(read(pong[0], &c, 1) != 1){
+      printf(1, "ctxbench: read failed\n");
+      break;
+    }
+  }
+  us = usecsince(start);
+  wait();
+  printf(1, "ctxbench: %d round trips in %d us, %d ns each\n",
+         N, us, divq((uint64)us * 1000, N, 0));
+  exit();
+}
@@ -5,11 +5,20 @@ struct inode;
 struct pipe;
 struct proc;
 struct rtcdate;
+struct rusage;
+struct procinfo;
+struct sample;
 struct spinlock;
+struct lockstat;
+struct ltresult;
 struct sleeplock;
 struct reentrantlock;
+struct vdsotime;
 struct stat;
 struct superblock;
+struct trace;
+struct trapframe;
+struct uimage;
 
 
 // bio.c
@@ -26,6 +35,8 @@ void            panic(char*) __attribute__((noreturn));
 
 // exec.c
 int             exec(char*, char**);
+int             loadimage(char*, char**, struct uimage*);
+void            freeimage(struct uimage*);
 
 // file.c
 struct file*    filealloc(void);
@@ -33,6 +44,7 @@ void            fileclose(struct file*);
 struct file*    filedup(struct file*);
 void            fileinit(void);
 int             fileread(struct file*, char*, int n);
+int             fileseek(struct file*, int, int);
 int             filestat(struct file*, struct stat*);
 int             filewrite(struct file*, char*, int n);
 
@@ -42,6 +54,7 @@ int             dirlink(struct inode*, char*, uint);
 struct inode*   dirlookup(struct inode*, char*, uint*);
 struct inode*   ialloc(uint, short);
 struct inode*   idup(struct inode*);
+struct inode*   iget(uint, uint);
 void            iinit(int dev);
 void            ilock(struct inode*);
 void            iput(struct inode*);
@@ -70,6 +83,9 @@ char*           kalloc(void);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
+void            kref(char*);
+int             krefcnt(char*);
+uint            kfreepages(uint*);
 
 // kbd.c
 void            kbdintr(void);
@@ -80,9 +96,19 @@ int             lapicid(void);
 extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
+void            lapicipi(int, int);
+void            lapiconeshot(int);
+uint64          nsuptime(void);
+uint            tscus(uint64);
+extern uint     tsckhz;
+extern uint64   tscboot;
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
+// locktest.c
+void            locktestinit(void);
+int             locktest(int, int, int, struct ltresult*);
+
 // log.c
 void            initlog(int dev);
 void            log_write(struct buf*);
@@ -108,6 +134,7 @@ int             pipewrite(struct pipe*, char*, int);
 int             cpuid(void);
 void            exit(void);
 int             fork(void);
+int             spawn(char*, char**, int*);
 int             growproc(int);
 int             kill(int);
 struct cpu*     mycpu(void);
@@ -128,16 +155,26 @@ void            create_palindrome(int);
 int             sort_syscalls(int);
 int             list_all_processes(void);
 int             get_most_invoked_syscall(int);
+int             syscall_latency(int);
+void            chargetime(struct proc*, int);
+int             getrusage(int, struct rusage*);
+int             getprocs(uint, int);
+int             snapprocs(struct procinfo*, int, int*);
+struct proc*    lockproc(int);
+void            unlockproc(void);
 void            change_queue(int, int);
 void            processes_info(void);
 void            set_bc(int, int, int);
 void            get_syscalls_num(void);
+void            cpus_info(void);
+void            armtimer(void);
 
 // swtch.S
 void            swtch(struct context**, struct context*);
 
 // spinlock.c
 void            acquire(struct spinlock*);
+int             lockstats(struct lockstat*, int);
 void            getcallerpcs(void*, uint*);
 int             holding(struct spinlock*);
 void            initlock(struct spinlock*, char*);
@@ -145,6 +182,18 @@ void            release(struct spinlock*);
 void            pushcli(void);
 void            popcli(void);
 
+// shm.c
+void            shminit(void);
+int             shmopen(int, uint);
+uint            shmsize(int);
+char*           shmpage(int, int);
+void            shmdup(int);
+void            shmclose(int);
+void            shmfork(struct proc*);
+void            shmexit(void);
+int             futexwait(uint, int);
+int             futexwake(uint);
+
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
 void            releasesleep(struct sleeplock*);
@@ -172,12 +221,30 @@ int             argstr(int, char**);
 int             fetchint(uint, int*);
 int             fetchstr(uint, char**);
 void            syscall(void);
+char*           syscallname(int);
 
 // timer.c
 void            timerinit(void);
 
+// procfs.c
+void            procfsinit(void);
+
+// prof.c
+void            profinit(void);
+void            profsample(struct trapframe*);
+int             profile(int, struct sample*, int);
+extern int      profiling;
+
+// trace.c
+void            traceinit(void);
+void            trace(int, int, int, int, char*);
+int             readtrace(struct trace*, int);
+extern int      tracing;
+
 // trap.c
 void            idtinit(void);
+void            systrap(struct trapframe*);
+void            countsyscall(int);
 extern uint     ticks;
 void            tvinit(void);
 extern struct spinlock tickslock;
@@ -204,6 +271,18 @@ void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
+int             uvmfault(struct proc*, uint, int);
+void            textinit(void);
+void            textinval(struct inode*);
+int             uvmtouch(struct proc*, uint, uint, int);
+uint            uvmlimit(struct proc*, uint);
+int             mmap(uint, uint, int, int, struct file*, uint);
+int             munmap(uint, uint);
+int             vmacopy(struct proc*);
+int             shmattach(int);
+void            vdsoinit(void);
+extern struct vdsotime *vdso;
+int             shmdetach(uint);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x)/sizeof((x)[0]))
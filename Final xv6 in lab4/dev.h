@@ -0,0 +1,5 @@
+// Major device numbers: the devsw[] slot of each device, and
+// what user programs pass to mknod().
+
+#define CONSOLE 1
+#define PROCFS  2  // kernel statistics, see procfs.c
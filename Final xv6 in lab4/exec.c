@@ -7,19 +7,23 @@
 #include "x86.h"
 #include "elf.h"
 
-
+// Load the program at path into a fresh page table and push
+// argv onto its user stack.  Nothing in the calling process
+// is modified, so exec() and spawn() can both commit the image
+// only once it is known to be good.
 int
-exec(char *path, char **argv)
+loadimage(char *path, char **argv, struct uimage *img)
 {
   char *s, *last;
   int i, off;
   uint argc, sz, sp, ustack[3+MAXARG+1];
   struct elfhdr elf;
-  struct inode *ip;
+  struct inode *ip, *exe;
   struct proghdr ph;
-  pde_t *pgdir, *oldpgdir;
-  struct proc *curproc = myproc();
+  struct execseg *seg;
+  pde_t *pgdir;
 
+  exe = 0;
   begin_op();
 
   if((ip = namei(path)) == 0){
@@ -39,8 +43,11 @@ exec(char *path, char **argv)
   if((pgdir = setupkvm()) == 0)
     goto bad;
 
-  // Load program into memory.
+  // Record the program's segments.  Nothing is read yet: pages
+  // come from ip when first touched (see uvmfault), so the image
+  // keeps a reference to the inode.
   sz = 0;
+  img->nexecseg = 0;
   for(i=0, off=elf.phoff; i<elf.phnum; i++, off+=sizeof(ph)){
     if(readi(ip, (char*)&ph, off, sizeof(ph)) != sizeof(ph))
       goto bad;
@@ -50,15 +57,23 @@ exec(char *path, char **argv)
       goto bad;
     if(ph.vaddr + ph.memsz < ph.vaddr)
       goto bad;
-    if((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
+    if(ph.vaddr + ph.memsz >= MMAPBASE)
       goto bad;
     if(ph.vaddr % PGSIZE != 0)
       goto bad;
-    if(loaduvm(pgdir, (char*)ph.vaddr, ip, ph.off, ph.filesz) < 0)
+    if(img->nexecseg == NEXECSEG)
       goto bad;
+    seg = &img->execseg[img->nexecseg++];
+    seg->vaddr = ph.vaddr;
+    seg->memsz = ph.memsz;
+    seg->filesz = ph.filesz;
+    seg->off = ph.off;
+    if(ph.vaddr + ph.memsz > sz)
+      sz = ph.vaddr + ph.memsz;
   }
-  iunlockput(ip);
+  iunlock(ip);
   end_op();
+  exe = ip;
   ip = 0;
 
   // Allocate two pages at the next page boundary.
@@ -92,14 +107,66 @@ exec(char *path, char **argv)
   for(last=s=path; *s; s++)
     if(*s == '/')
       last = s+1;
-  safestrcpy(curproc->name, last, sizeof(curproc->name));
+  safestrcpy(img->name, last, sizeof(img->name));
+
+  img->pgdir = pgdir;
+  img->sz = sz;
+  img->entry = elf.entry;
+  img->sp = sp;
+  img->exe = exe;
+  return 0;
+
+ bad:
+  if(pgdir)
+    freevm(pgdir);
+  if(ip){
+    iunlockput(ip);
+    end_op();
+  }
+  if(exe){
+    begin_op();
+    iput(exe);
+    end_op();
+  }
+  return -1;
+}
+
+// Release an image that loadimage() built but nobody committed.
+void
+freeimage(struct uimage *img)
+{
+  freevm(img->pgdir);
+  begin_op();
+  iput(img->exe);
+  end_op();
+}
+
+int
+exec(char *path, char **argv)
+{
+  struct uimage img;
+  pde_t *oldpgdir;
+  struct inode *oldexe;
+  struct proc *curproc = myproc();
+
+  if(loadimage(path, argv, &img) < 0)
+    return -1;
+
+  safestrcpy(curproc->name, img.name, sizeof(curproc->name));
+
+  // The new image starts with no mmap() regions.
+  munmap(MMAPBASE, VDSOBASE - MMAPBASE);
 
   // Commit to the user image.
   oldpgdir = curproc->pgdir;
-  curproc->pgdir = pgdir;
-  curproc->sz = sz;
-  curproc->tf->eip = elf.entry;  // main
-  curproc->tf->esp = sp;
+  curproc->pgdir = img.pgdir;
+  curproc->sz = img.sz;
+  curproc->tf->eip = img.entry;  // main
+  curproc->tf->esp = img.sp;
+  oldexe = curproc->exe;
+  curproc->exe = img.exe;
+  curproc->nexecseg = img.nexecseg;
+  memmove(curproc->execseg, img.execseg, sizeof(img.execseg));
   switchuvm(curproc);
 
   // for(int i = 0; i < NCPU; i++)
@@ -113,14 +180,10 @@ exec(char *path, char **argv)
     curproc->schedqueue = FCFS;
     
   freevm(oldpgdir);
-  return 0;
-
- bad:
-  if(pgdir)
-    freevm(pgdir);
-  if(ip){
-    iunlockput(ip);
+  if(oldexe){
+    begin_op();
+    iput(oldexe);
     end_op();
   }
-  return -1;
+  return 0;
 }
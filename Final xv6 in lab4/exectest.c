@@ -0,0 +1,64 @@
+// Demand-paged exec: time repeated execs of the same binary,
+// and check that a process writing its data segment does not
+// disturb later runs that share the executable's pages.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NEXEC 50
+
+int marker = 42;  // lives in the shared, file-backed segment
+
+void
+child(void)
+{
+  if(marker != 42){
+    printf(1, "exectest: saw a modified data page (%d)\n", marker);
+    exit();
+  }
+  marker = 7;
+  exit();
+}
+
+int
+runs(char *path, char **argv, int n)
+{
+  int i, pid, start;
+
+  start = uptime();
+  for(i = 0; i < n; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(1, "exectest: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(path, argv);
+      printf(1, "exectest: exec %s failed\n", path);
+      exit();
+    }
+    wait();
+  }
+  return uptime() - start;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *cargv[] = { "exectest", "child", 0 };
+  int first, rest;
+
+  if(argc > 1 && strcmp(argv[1], "child") == 0)
+    child();
+
+  first = runs("exectest", cargv, 1);
+  rest = runs("exectest", cargv, NEXEC);
+  printf(1, "exectest: first exec %d ticks, %d more in %d ticks\n",
+         first, NEXEC, rest);
+  if(marker != 42)
+    printf(1, "exectest: parent data page changed\n");
+  else
+    printf(1, "exectest ok\n");
+  exit();
+}
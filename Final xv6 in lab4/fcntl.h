@@ -2,3 +2,7 @@
 #define O_WRONLY  0x001
 #define O_RDWR    0x002
 #define O_CREATE  0x200
+
+#define SEEK_SET  0  // lseek() from the start of the file
+#define SEEK_CUR  1  // from the current offset
+#define SEEK_END  2  // from the end
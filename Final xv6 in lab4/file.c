@@ -9,6 +9,8 @@
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "stat.h"
+#include "fcntl.h"
 
 struct devsw devsw[NDEV];
 struct {
@@ -112,6 +114,36 @@ fileread(struct file *f, char *addr, int n)
   panic("fileread");
 }
 
+// Move file f's offset as lseek() does, and return it.
+// Only a device may be read from past the end of its inode.
+int
+fileseek(struct file *f, int off, int whence)
+{
+  uint base;
+
+  if(f->type != FD_INODE)
+    return -1;
+  ilock(f->ip);
+  if(whence == SEEK_SET)
+    base = 0;
+  else if(whence == SEEK_CUR)
+    base = f->off;
+  else if(whence == SEEK_END)
+    base = f->ip->size;
+  else
+    goto bad;
+  if((off < 0 && -off > base) ||
+     (f->ip->type != T_DEV && base + off > f->ip->size))
+    goto bad;
+  f->off = base + off;
+  iunlock(f->ip);
+  return f->off;
+
+bad:
+  iunlock(f->ip);
+  return -1;
+}
+
 //PAGEBREAK!
 // Write to file f.
 int
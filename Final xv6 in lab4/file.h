@@ -26,12 +26,13 @@ struct inode {
 };
 
 // table mapping major device number to
-// device functions
+// device functions.  read gets the file offset too.  A
+// device with lookup acts as a directory: namei() asks it
+// for the inode of each name below it.
 struct devsw {
-  int (*read)(struct inode*, char*, int);
+  int (*read)(struct inode*, char*, int, uint);
   int (*write)(struct inode*, char*, int);
+  struct inode *(*lookup)(struct inode*, char*);
 };
 
 extern struct devsw devsw[];
-
-#define CONSOLE 1
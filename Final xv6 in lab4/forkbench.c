@@ -0,0 +1,42 @@
+// Time fork()+wait() and fork()+exec()+wait() round trips.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define N 200
+
+int
+main(int argc, char *argv[])
+{
+  int i;
+  uint64 start;
+  uint tf, te;
+  char *args[] = { "forkbench", "child", 0 };
+
+  if(argc > 1 && strcmp(argv[1], "child") == 0)
+    exit();
+
+  start = nsec();
+  for(i = 0; i < N; i++){
+    if(fork() == 0)
+      exit();
+    wait();
+  }
+  tf = usecsince(start);
+
+  start = nsec();
+  for(i = 0; i < N; i++){
+    if(fork() == 0){
+      exec("forkbench", args);
+      printf(1, "forkbench: exec failed\n");
+      exit();
+    }
+    wait();
+  }
+  te = usecsince(start);
+
+  printf(1, "forkbench: %d rounds: fork %d us each, fork+exec %d us each\n",
+         N, tf / N, te / N);
+  exit();
+}
@@ -185,8 +185,6 @@ iinit(int dev)
           sb.bmapstart);
 }
 
-static struct inode* iget(uint dev, uint inum);
-
 //PAGEBREAK!
 // Allocate an inode on device dev.
 // Mark it as allocated by  giving it type type.
@@ -238,7 +236,7 @@ iupdate(struct inode *ip)
 // Find the inode with number inum on device dev
 // and return the in-memory copy. Does not lock
 // the inode and does not read it from disk.
-static struct inode*
+struct inode*
 iget(uint dev, uint inum)
 {
   struct inode *ip, *empty;
@@ -432,6 +430,7 @@ itrunc(struct inode *ip)
 
   ip->size = 0;
   iupdate(ip);
+  textinval(ip);
 }
 
 // Copy stat information from inode.
@@ -458,7 +457,7 @@ readi(struct inode *ip, char *dst, uint off, uint n)
   if(ip->type == T_DEV){
     if(ip->major < 0 || ip->major >= NDEV || !devsw[ip->major].read)
       return -1;
-    return devsw[ip->major].read(ip, dst, n);
+    return devsw[ip->major].read(ip, dst, n, off);
   }
 
   if(off > ip->size || off + n < off)
@@ -494,6 +493,7 @@ writei(struct inode *ip, char *src, uint off, uint n)
     return -1;
   if(off + n > MAXFILE*BSIZE)
     return -1;
+  textinval(ip);
 
   for(tot=0; tot<n; tot+=m, off+=m, src+=m){
     bp = bread(ip->dev, bmap(ip, off/BSIZE));
@@ -617,6 +617,14 @@ skipelem(char *path, char *name)
   return path;
 }
 
+// Is ip a device that acts as a directory?  Caller holds ip's lock.
+static int
+devdir(struct inode *ip)
+{
+  return ip->type == T_DEV && ip->major >= 0 && ip->major < NDEV &&
+         devsw[ip->major].lookup;
+}
+
 // Look up and return the inode for a path name.
 // If parent != 0, return the inode for the parent and copy the final
 // path element into name, which must have room for DIRSIZ bytes.
@@ -633,16 +641,25 @@ namex(char *path, int nameiparent, char *name)
 
   while((path = skipelem(path, name)) != 0){
     ilock(ip);
-    if(ip->type != T_DIR){
+    if(ip->type != T_DIR && !devdir(ip)){
       iunlockput(ip);
       return 0;
     }
     if(nameiparent && *path == '\0'){
-      // Stop one level early.
+      // Stop one level early.  Nothing can be created in
+      // or removed from a device's directory.
+      if(ip->type != T_DIR){
+        iunlockput(ip);
+        return 0;
+      }
       iunlock(ip);
       return ip;
     }
-    if((next = dirlookup(ip, name, 0)) == 0){
+    if(ip->type == T_DIR)
+      next = dirlookup(ip, name, 0);
+    else
+      next = devsw[ip->major].lookup(ip, name);
+    if(next == 0){
       iunlockput(ip);
       return 0;
     }
@@ -0,0 +1,255 @@
+// Measure file system operation rates, to see the effect of
+// changes to bio.c, log.c and fs.c.  Each test runs in one
+// process and then in nproc at once, in a shared directory:
+//
+//   create    empty files made, nfile in all
+//   lookup    stat()s of random names in that directory
+//   unlink    those files removed
+//   write     sequential writes of a MAXFILE-block file each
+//   read      sequential reads of it
+//   randread  512-byte reads of it at random offsets
+//
+// usage: fsbench [nproc [nfile]]
+//
+// The default nfile of 500 makes the directory 16 blocks long,
+// past its direct blocks.  mkfs leaves room for about 900.
+//
+// Output is one line per test and process count, with keys in
+// a fixed order so that runs can be compared: rates are in
+// operations per second, or MB per second for write and read.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fs.h"
+#include "fcntl.h"
+#include "x86.h"
+
+#define NPROCS   8
+#define NLOOKUP  512        // stat()s per process
+#define NRAND    512        // random reads per process
+#define NROUND   4          // passes over the file per process
+#define FILESIZE (MAXFILE*BSIZE)
+#define CHUNK    4096
+#define MAXNFILE 900        // inodes mkfs leaves free, roughly
+
+int nfile = 500;
+char buf[CHUNK];
+
+uint
+rand(uint *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+// The name of file i of process id: "f" id i.
+char*
+fname(int id, int i)
+{
+  static char name[8];
+
+  name[0] = 'f';
+  name[1] = 'a' + id;
+  name[2] = '0' + i / 100;
+  name[3] = '0' + i / 10 % 10;
+  name[4] = '0' + i % 10;
+  name[5] = 0;
+  return name;
+}
+
+// The name of process id's large file.
+char*
+sname(int id)
+{
+  static char name[4];
+
+  name[0] = 's';
+  name[1] = 'a' + id;
+  name[2] = 0;
+  return name;
+}
+
+void
+create(int id, int nproc)
+{
+  int i, fd;
+
+  for(i = 0; i < nfile / nproc; i++){
+    if((fd = open(fname(id, i), O_CREATE | O_RDWR)) < 0)
+      fail("fsbench", "create");
+    close(fd);
+  }
+}
+
+void
+lookup(int id, int nproc)
+{
+  struct stat st;
+  uint seed, r;
+  int i;
+
+  seed = id + 1;
+  for(i = 0; i < NLOOKUP; i++){
+    r = rand(&seed);
+    if(stat(fname(r % nproc, r / nproc % (nfile / nproc)), &st) < 0)
+      fail("fsbench", "lookup");
+  }
+}
+
+void
+remove(int id, int nproc)
+{
+  int i;
+
+  for(i = 0; i < nfile / nproc; i++)
+    if(unlink(fname(id, i)) < 0)
+      fail("fsbench", "unlink");
+}
+
+void
+writefile(int id, int nproc)
+{
+  int r, off, n, fd;
+
+  for(r = 0; r < NROUND; r++){
+    unlink(sname(id));
+    if((fd = open(sname(id), O_CREATE | O_RDWR)) < 0)
+      fail("fsbench", "open");
+    for(off = 0; off < FILESIZE; off += n){
+      n = FILESIZE - off < CHUNK ? FILESIZE - off : CHUNK;
+      if(write(fd, buf, n) != n)
+        fail("fsbench", "write");
+    }
+    close(fd);
+  }
+}
+
+void
+readfile(int id, int nproc)
+{
+  int r, fd, n, tot;
+
+  for(r = 0; r < NROUND; r++){
+    if((fd = open(sname(id), O_RDONLY)) < 0)
+      fail("fsbench", "open");
+    tot = 0;
+    while((n = read(fd, buf, CHUNK)) > 0)
+      tot += n;
+    close(fd);
+    if(tot != FILESIZE)
+      fail("fsbench", "read");
+  }
+}
+
+void
+randread(int id, int nproc)
+{
+  uint seed;
+  int i, fd;
+
+  seed = id + 1;
+  if((fd = open(sname(id), O_RDONLY)) < 0)
+    fail("fsbench", "open");
+  for(i = 0; i < NRAND; i++){
+    if(lseek(fd, rand(&seed) % MAXFILE * BSIZE, SEEK_SET) < 0 ||
+       read(fd, buf, BSIZE) != BSIZE)
+      fail("fsbench", "randread");
+  }
+  close(fd);
+}
+
+struct test {
+  char *name;
+  void (*fn)(int, int);
+  int bytes;  // rate is MB/s, not operations/s
+} tests[] = {
+  { "create",   create,    0 },
+  { "lookup",   lookup,    0 },
+  { "unlink",   remove,    0 },
+  { "write",    writefile, 1 },
+  { "read",     readfile,  1 },
+  { "randread", randread,  0 },
+};
+
+// Operations (or bytes) one process does in test t.
+uint
+work(struct test *t, int nproc)
+{
+  if(t->fn == create || t->fn == remove)
+    return nfile / nproc;
+  if(t->fn == lookup)
+    return NLOOKUP;
+  if(t->fn == randread)
+    return NRAND;
+  return NROUND * FILESIZE;
+}
+
+void
+run(struct test *t, int nproc)
+{
+  uint64 start;
+  uint us, n;
+  int i;
+
+  start = nsec();
+  for(i = 0; i < nproc; i++){
+    if(fork() == 0){
+      t->fn(i, nproc);
+      exit();
+    }
+  }
+  for(i = 0; i < nproc; i++)
+    wait();
+  us = usecsince(start);
+  if(us == 0)
+    us = 1;
+
+  n = work(t, nproc) * nproc;
+  if(t->bytes){
+    printf(1, "test=%s nproc=%d bytes=%d us=%d mb_per_s=", t->name, nproc, n, us);
+    fixed(divq((uint64)n * 1000, us, 0));
+    printf(1, "\n");
+  } else
+    printf(1, "test=%s nproc=%d n=%d us=%d per_s=%d\n", t->name, nproc, n, us,
+           divq((uint64)n * 1000000, us, 0));
+}
+
+void
+suite(int nproc)
+{
+  int i;
+
+  for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    run(&tests[i], nproc);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int nproc, i;
+
+  nproc = argc > 1 ? atoi(argv[1]) : 4;
+  if(argc > 2)
+    nfile = atoi(argv[2]);
+  if(nproc < 1 || nproc > NPROCS || nfile < nproc || nfile > MAXNFILE){
+    printf(2, "usage: fsbench [nproc [nfile]], nproc <= %d, nfile <= %d\n",
+           NPROCS, MAXNFILE);
+    exit();
+  }
+
+  memset(buf, 'f', sizeof(buf));
+  mkdir("fsb");  // may be left from an earlier run
+  if(chdir("fsb") < 0)
+    fail("fsbench", "chdir fsb");
+
+  suite(1);
+  if(nproc > 1)
+    suite(nproc);
+
+  for(i = 0; i < nproc; i++)
+    unlink(sname(i));
+  chdir("..");
+  unlink("fsb");
+  exit();
+}
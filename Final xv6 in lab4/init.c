@@ -4,6 +4,7 @@
 #include "stat.h"
 #include "user.h"
 #include "fcntl.h"
+#include "dev.h"
 
 char *argv[] = { "sh", 0 };
 
@@ -13,11 +14,12 @@ main(void)
   int pid, wpid;
 
   if(open("console", O_RDWR) < 0){
-    mknod("console", 1, 1);
+    mknod("console", CONSOLE, 1);
     open("console", O_RDWR);
   }
   dup(0);  // stdout
   dup(0);  // stderr
+  mknod("proc", PROCFS, 0);  // fails if already made
 
   for(;;){
     printf(1, "init: starting sh\n");
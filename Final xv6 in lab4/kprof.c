@@ -0,0 +1,202 @@
+// Run a command with the profiler on, then print where the
+// timer ticks found each CPU, by function, most first.  Kernel
+// addresses are looked up in /kernel.sym and user addresses in
+// /prog.sym for the process's name.
+//
+//   kprof forkbench
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "param.h"
+#include "prof.h"
+
+#define NSAMPLE (NCPU*NPROFSAMPLE)
+#define NSYMTAB 4    // symbol tables loaded at once
+#define NSYM 1024    // symbols per table
+#define NHIT 256     // distinct functions counted
+
+struct symtab {
+  char prog[16];     // "kernel", or a process name
+  char *buf;         // the file, which name[] points into
+  int n;
+  uint addr[NSYM];
+  char *name[NSYM];
+};
+
+struct hit {
+  char prog[16];
+  char *fn;
+  int n;
+};
+
+static struct sample samples[NSAMPLE];
+static struct symtab symtab[NSYMTAB];
+static struct hit hits[NHIT];
+static int nhit;
+
+static int
+hexval(char c)
+{
+  if(c >= '0' && c <= '9')
+    return c - '0';
+  if(c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// Load prog.sym: lines of 8 hex digits, a space and a name,
+// as the Makefile writes them.
+static void
+loadsyms(struct symtab *st, char *prog)
+{
+  char path[32], *buf, *p, *e, *end;
+  struct stat sb;
+  int fd, i, v;
+
+  strcpy(st->prog, prog);
+  if(st->buf)
+    free(st->buf);
+  st->buf = 0;
+  st->n = 0;
+  strcpy(path, prog);
+  strcpy(path + strlen(path), ".sym");
+  if((fd = open(path, O_RDONLY)) < 0)
+    return;
+  if(fstat(fd, &sb) < 0 || (buf = malloc(sb.size + 1)) == 0){
+    close(fd);
+    return;
+  }
+  if(read(fd, buf, sb.size) != sb.size){
+    close(fd);
+    free(buf);
+    return;
+  }
+  close(fd);
+  end = buf + sb.size;
+  *end = 0;
+
+  for(p = buf; p < end && st->n < NSYM; p = e + 1){
+    if((e = strchr(p, '\n')) == 0)
+      e = end;
+    *e = 0;
+    st->addr[st->n] = 0;
+    for(i = 0; i < 8; i++){
+      if((v = hexval(p[i])) < 0)
+        break;
+      st->addr[st->n] = st->addr[st->n] * 16 + v;
+    }
+    if(i != 8 || p[8] != ' '){
+      // Not a symbol table after all: a long name got cut
+      // down to the program's own.
+      st->n = 0;
+      free(buf);
+      return;
+    }
+    st->name[st->n++] = p + 9;
+  }
+  st->buf = buf;
+}
+
+static struct symtab*
+findsyms(char *prog)
+{
+  static int next;
+  struct symtab *st;
+
+  for(st = symtab; st < &symtab[NSYMTAB]; st++)
+    if(st->prog[0] && strcmp(st->prog, prog) == 0)
+      return st;
+  st = &symtab[next++ % NSYMTAB];
+  loadsyms(st, prog);
+  return st;
+}
+
+// The function in st holding eip, or 0.
+static char*
+lookup(struct symtab *st, uint eip)
+{
+  char *fn;
+  uint best;
+  int i;
+
+  fn = 0;
+  best = 0;
+  for(i = 0; i < st->n; i++)
+    if(st->addr[i] <= eip && st->addr[i] >= best){
+      best = st->addr[i];
+      fn = st->name[i];
+    }
+  return fn;
+}
+
+static void
+count(char *prog, char *fn)
+{
+  struct hit *h;
+
+  for(h = hits; h < &hits[nhit]; h++)
+    if(strcmp(h->prog, prog) == 0 && strcmp(h->fn, fn) == 0){
+      h->n++;
+      return;
+    }
+  if(nhit == NHIT)
+    return;
+  h = &hits[nhit++];
+  strcpy(h->prog, prog);
+  h->fn = fn;
+  h->n = 1;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct symtab *st;
+  struct sample *s;
+  struct hit h;
+  char *fn;
+  int n, i, j, idle;
+
+  if(argc < 2){
+    printf(2, "usage: kprof command [args]\n");
+    exit();
+  }
+
+  profile(PROF_START, 0, 0);
+  if(fork() == 0){
+    exec(argv[1], argv + 1);
+    printf(2, "kprof: exec %s failed\n", argv[1]);
+    exit();
+  }
+  wait();
+  profile(PROF_STOP, 0, 0);
+  if((n = profile(PROF_DUMP, samples, NSAMPLE)) < 0){
+    printf(2, "kprof: dump failed\n");
+    exit();
+  }
+
+  idle = 0;
+  for(s = samples; s < &samples[n]; s++){
+    if(s->pid == 0){
+      idle++;
+      continue;
+    }
+    st = findsyms(s->user ? s->name : "kernel");
+    if((fn = lookup(st, s->eip)) == 0)
+      fn = "?";
+    count(st->prog, fn);
+  }
+
+  // Most samples first.
+  for(i = 1; i < nhit; i++){
+    h = hits[i];
+    for(j = i; j > 0 && hits[j-1].n < h.n; j--)
+      hits[j] = hits[j-1];
+    hits[j] = h;
+  }
+  printf(1, "%d samples, %d in the scheduler or idle\n", n, idle);
+  for(i = 0; i < nhit; i++)
+    printf(1, "%d %s %s\n", hits[i].n, hits[i].prog, hits[i].fn);
+  exit();
+}
@@ -0,0 +1,104 @@
+// Run a command with kernel tracing on, then print the events
+// it caused (and anything else that ran meanwhile) in time
+// order, in microseconds since the first.
+//
+//   ktrace forkbench
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "x86.h"
+#include "trace.h"
+#include "vdso.h"
+
+#define NREC (NCPU*NTRACE)
+#define NELEM(x) (sizeof(x)/sizeof((x)[0]))
+
+static struct trace rec[NREC];
+static int order[NREC];
+static char *queues[] = { "RR", "SJF", "FCFS" };
+static char *states[] = { "unused", "embryo", "sleeping", "runnable",
+                          "running", "zombie" };
+
+static char*
+qname(int q)
+{
+  return q >= 0 && q < NELEM(queues) ? queues[q] : "?";
+}
+
+static void
+print(struct trace *t, uint64 t0)
+{
+  uint khz = ((struct vdsotime*)VDSOTIME)->tsckhz;
+  char name[sizeof(t->name) + 1];
+  uint us;
+
+  memmove(name, t->name, sizeof(t->name));
+  name[sizeof(t->name)] = 0;
+  us = khz ? divq((t->tsc - t0) * 1000, khz, 0) : (uint)(t->tsc - t0);
+  printf(1, "%d cpu%d ", us, t->cpu);
+  switch(t->type){
+  case TR_SWITCH:
+    printf(1, "switch %d (%s) -> %d %s\n", t->a,
+           t->c >= 0 && t->c < NELEM(states) ? states[t->c] : "?", t->b, name);
+    break;
+  case TR_WAKEUP:
+    printf(1, "wakeup %d %s in %s\n", t->a, name, qname(t->b));
+    break;
+  case TR_QUEUE:
+    if(t->a == 0)
+      printf(1, "turn %s -> %s\n", qname(t->b), qname(t->c));
+    else
+      printf(1, "queue %d %s %s -> %s\n", t->a, name, qname(t->b), qname(t->c));
+    break;
+  case TR_SYSENTER:
+    printf(1, "enter %d %s\n", t->a, name);
+    break;
+  case TR_SYSEXIT:
+    printf(1, "exit %d %s = %d\n", t->a, name, t->c);
+    break;
+  case TR_LOCK:
+    printf(1, "contend %d %s spun %d\n", t->a, name, t->b);
+    break;
+  default:
+    printf(1, "type %d\n", t->type);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n, m, i, j, k;
+
+  if(argc < 2){
+    printf(2, "usage: ktrace command [args]\n");
+    exit();
+  }
+
+  readtrace(0, 1);
+  if(fork() == 0){
+    exec(argv[1], argv + 1);
+    printf(2, "ktrace: exec %s failed\n", argv[1]);
+    exit();
+  }
+  wait();
+
+  // Stop first, so that collecting is not itself traced.
+  readtrace(0, 0);
+  n = 0;
+  while(n < NREC && (m = readtrace(rec + n, NREC - n)) > 0)
+    n += m;
+
+  // Each CPU's records are in order already; merge them.
+  for(i = 0; i < n; i++){
+    k = i;
+    for(j = i; j > 0 && rec[order[j-1]].tsc > rec[k].tsc; j--)
+      order[j] = order[j-1];
+    order[j] = k;
+  }
+  for(i = 0; i < n; i++)
+    print(&rec[order[i]], rec[order[0]].tsc);
+  printf(1, "ktrace: %d events\n", n);
+  exit();
+}
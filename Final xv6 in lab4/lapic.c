@@ -31,6 +31,7 @@
 #define ICRHI   (0x0310/4)   // Interrupt Command [63:32]
 #define TIMER   (0x0320/4)   // Local Vector Table 0 (TIMER)
   #define X1         0x0000000B   // divide counts by 1
+  #define ONESHOT    0x00000000   // One-shot
   #define PERIODIC   0x00020000   // Periodic
 #define PCINT   (0x0340/4)   // Performance Counter LVT
 #define LINT0   (0x0350/4)   // Local Vector Table 1 (LINT0)
@@ -41,7 +42,18 @@
 #define TCCR    (0x0390/4)   // Timer Current Count
 #define TDCR    (0x03E0/4)   // Timer Divide Configuration
 
+// The PIT's channel 2 can be polled without an interrupt, and
+// counts at a known rate: the reference for calibration.
+#define PIT_CH2    0x42
+#define PIT_MODE   0x43
+#define PIT_GATE   0x61     // bit 0: channel 2 gate, bit 5: its output
+#define PIT_HZ     1193182
+#define CALMS      10       // calibrate over this many milliseconds
+
 volatile uint *lapic;  // Initialized in mp.c
+uint tsckhz;           // TSC cycles per millisecond, 0 if unknown
+uint64 tscboot;        // TSC at calibration
+static uint tickcount = 10000000;  // timer counts per tick (10ms)
 
 //PAGEBREAK!
 static void
@@ -51,6 +63,67 @@ lapicw(int index, int value)
   lapic[ID];  // wait for write to finish, by reading
 }
 
+// Time CALMS milliseconds on the PIT, counting TSC cycles and
+// LAPIC timer counts meanwhile.  Run once, on the boot CPU; the
+// other CPUs are assumed to run their clocks at the same rates.
+static void
+calibrate(void)
+{
+  uint64 t0, t1;
+  uint left;
+
+  outb(PIT_GATE, (inb(PIT_GATE) & ~0x02) | 0x01);  // gate on, speaker off
+  outb(PIT_MODE, 0xB0);  // channel 2, lo/hi byte, count down once
+  outb(PIT_CH2, (PIT_HZ / (1000 / CALMS)) & 0xFF);
+  outb(PIT_CH2, (PIT_HZ / (1000 / CALMS)) >> 8);
+
+  lapicw(TDCR, X1);
+  lapicw(TIMER, MASKED | ONESHOT);
+  lapicw(TICR, 0xFFFFFFFF);
+  t0 = rdtsc();
+  while((inb(PIT_GATE) & 0x20) == 0)
+    ;
+  t1 = rdtsc();
+  left = lapic[TCCR];
+  lapicw(TICR, 0);
+
+  tsckhz = divq(t1 - t0, CALMS, 0);
+  tscboot = t1;
+  if(left != 0)
+    tickcount = (0xFFFFFFFF - left) * (10 / CALMS);
+  cprintf("lapic: tsc %d kHz, timer %d counts/tick\n", tsckhz, tickcount);
+}
+
+// Nanoseconds since calibration, from the TSC.
+uint64
+nsuptime(void)
+{
+  uint ms, rem;
+
+  if(tsckhz == 0)
+    return (uint64)ticks * 10000000;
+  ms = divq(rdtsc() - tscboot, tsckhz, &rem);
+  return (uint64)ms * 1000000 + divq((uint64)rem * 1000000, tsckhz, 0);
+}
+
+// Microseconds in n TSC cycles, or 0 if uncalibrated.
+// Saturates at 0xFFFFFFFF, a little over 71 minutes, since
+// divq() faults on a quotient that does not fit.
+uint
+tscus(uint64 n)
+{
+  uint ms, rem;
+
+  if(tsckhz == 0)
+    return 0;
+  if((n >> 32) >= tsckhz)
+    return 0xFFFFFFFF;
+  ms = divq(n, tsckhz, &rem);
+  if(ms >= 0xFFFFFFFF / 1000)
+    return 0xFFFFFFFF;
+  return ms * 1000 + divq((uint64)rem * 1000, tsckhz, 0);
+}
+
 void
 lapicinit(void)
 {
@@ -60,13 +133,15 @@ lapicinit(void)
   // Enable local APIC; set spurious interrupt vector.
   lapicw(SVR, ENABLE | (T_IRQ0 + IRQ_SPURIOUS));
 
+  if(tsckhz == 0)
+    calibrate();
+
   // The timer repeatedly counts down at bus frequency
   // from lapic[TICR] and then issues an interrupt.
-  // If xv6 cared more about precise timekeeping,
-  // TICR would be calibrated using an external time source.
+  // TICR was calibrated against the PIT, so a tick is 10ms.
   lapicw(TDCR, X1);
   lapicw(TIMER, PERIODIC | (T_IRQ0 + IRQ_TIMER));
-  lapicw(TICR, 10000000);
+  lapicw(TICR, tickcount);
 
   // Disable logical interrupt lines.
   lapicw(LINT0, MASKED);
@@ -113,6 +188,29 @@ lapiceoi(void)
     lapicw(EOI, 0);
 }
 
+// Make this CPU's timer interrupt once, n ticks from now,
+// instead of periodically; n == 0 stops it.
+void
+lapiconeshot(int n)
+{
+  if(!lapic)
+    return;
+  lapicw(TIMER, ONESHOT | (T_IRQ0 + IRQ_TIMER));
+  lapicw(TICR, n * tickcount);
+}
+
+// Send interrupt vector to the CPU with the given APIC id.
+void
+lapicipi(int apicid, int vector)
+{
+  if(!lapic)
+    return;
+  lapicw(ICRHI, apicid << 24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+}
+
 // Spin for a given number of microseconds.
 // On real hardware would want to tune this dynamically.
 void
@@ -0,0 +1,60 @@
+// Exercise lazily allocated heap pages: first touch from user
+// code, from system call arguments, and across fork().
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define BIG (8*1024*1024)
+
+int
+main(void)
+{
+  char *a, *b;
+  int fds[2], pid, start;
+
+  start = uptime();
+  if((a = sbrk(BIG)) == (char*)-1)
+    fail("lazytest", "sbrk");
+  printf(1, "lazytest: reserved %d bytes in %d ticks\n", BIG, uptime() - start);
+
+  // Touch from user code, far apart.
+  a[0] = 1;
+  a[BIG/2] = 2;
+  a[BIG-1] = 3;
+  if(a[0] != 1 || a[BIG/2] != 2 || a[BIG-1] != 3 || a[4096] != 0)
+    fail("lazytest", "user touch");
+
+  // Untouched pages as system call arguments: pipe() writes
+  // its result and read() fills a buffer the kernel must fault in.
+  b = a + 3*4096 + 100;
+  if(pipe((int*)(a + 5*4096)) < 0)
+    fail("lazytest", "pipe into untouched page");
+  fds[0] = ((int*)(a + 5*4096))[0];
+  fds[1] = ((int*)(a + 5*4096))[1];
+  if(write(fds[1], "lazy", 5) != 5 || read(fds[0], b, 5) != 5)
+    fail("lazytest", "pipe io");
+  if(strcmp(b, "lazy") != 0)
+    fail("lazytest", "read into untouched page");
+  close(fds[0]);
+  close(fds[1]);
+
+  // The child sees touched pages and can fault in the rest.
+  pid = fork();
+  if(pid < 0)
+    fail("lazytest", "fork");
+  if(pid == 0){
+    if(a[BIG/2] != 2 || strcmp(b, "lazy") != 0)
+      fail("lazytest", "child copy");
+    a[BIG/4] = 4;
+    exit();
+  }
+  wait();
+  if(a[BIG/4] != 0)
+    fail("lazytest", "child isolation");
+
+  if(sbrk(-BIG) == (char*)-1)
+    fail("lazytest", "shrink");
+  printf(1, "lazytest ok\n");
+  exit();
+}
@@ -0,0 +1,134 @@
+// Make processes contend for each kind of kernel lock through
+// locktest(), with critical sections of several lengths, and
+// report throughput, fairness and the wait-time distribution.
+//
+// usage: lockbench [nproc [ms [kind [cs]]]]
+//
+// kind is 0 spin, 1 ticket, 2 mcs, 3 sleep or 4 reentrant (see
+// locktest.h).  By default 4 processes run for 200 ms on every
+// kind of lock with critical sections of 0, 16, 256 and 4096
+// counter writes.  Wait percentiles are the upper bounds of
+// locktest's power-of-two histogram buckets.  Each result is a
+// line of key=value pairs starting "lock=".
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+#include "vdso.h"
+#include "locktest.h"
+
+#define NPROCS 16
+#define KEY    0x6c6b626e  // "lkbn"
+
+char *kinds[] = {
+  [LT_SPIN]      "spin",
+  [LT_TICKET]    "ticket",
+  [LT_MCS]       "mcs",
+  [LT_SLEEP]     "sleep",
+  [LT_REENTRANT] "reentrant",
+};
+int cslens[] = { 0, 16, 256, 4096 };
+
+struct shared {
+  volatile int ready;  // children waiting to start
+  volatile int go;
+  struct ltresult r[NPROCS];
+};
+
+struct shared *sh;
+
+uint
+ns(uint64 cycles)
+{
+  uint khz;
+
+  khz = ((struct vdsotime*)VDSOTIME)->tsckhz;
+  if(khz == 0)
+    return 0;
+  return divq(cycles * 1000000, khz, 0);
+}
+
+void
+run(int nproc, int ms, int kind, int cs)
+{
+  uint lat[NLTLAT];
+  uint64 ops, sumsq, waited;
+  uint errors, fair;
+  int i, b, top;
+
+  memset(sh, 0, sizeof(*sh));
+  for(i = 0; i < nproc; i++){
+    if(fork() == 0){
+      __sync_fetch_and_add(&sh->ready, 1);
+      while(!sh->go)
+        yield();
+      if(locktest(kind, ms, cs, &sh->r[i]) < 0)
+        fail("lockbench", "locktest");
+      exit();
+    }
+  }
+  while(sh->ready < nproc)
+    yield();
+  sh->go = 1;
+  for(i = 0; i < nproc; i++)
+    wait();
+
+  memset(lat, 0, sizeof(lat));
+  ops = sumsq = waited = errors = 0;
+  for(i = 0; i < nproc; i++){
+    ops += sh->r[i].ops;
+    sumsq += (uint64)sh->r[i].ops * sh->r[i].ops;
+    waited += sh->r[i].wait;
+    errors += sh->r[i].errors;
+    for(b = 0; b < NLTLAT; b++)
+      lat[b] += sh->r[i].lat[b];
+  }
+  if(ops == 0){
+    printf(1, "lock=%s cs=%d nproc=%d ops=0\n", kinds[kind], cs, nproc);
+    return;
+  }
+  for(top = NLTLAT - 1; top > 0 && lat[top] == 0; top--)
+    ;
+  fair = jain(ops, sumsq, nproc);
+
+  printf(1, "lock=%s cs=%d nproc=%d ops=%d ops_per_s=%d fairness=",
+         kinds[kind], cs, nproc, (uint)ops, divq(ops * 1000, ms, 0));
+  fixed(fair);
+  printf(1, " wait_ns=%d p50_ns=%d p99_ns=%d max_ns=%d errors=%d\n",
+         ns(divq(waited, ops, 0)), ns(percentile(lat, NLTLAT, ops, 50)),
+         ns(percentile(lat, NLTLAT, ops, 99)), ns((uint64)2 << top), errors);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int nproc, ms, kind, ncs, c, k, id;
+
+  nproc = argc > 1 ? atoi(argv[1]) : 4;
+  ms = argc > 2 ? atoi(argv[2]) : 200;
+  kind = argc > 3 ? atoi(argv[3]) : -1;
+  if(nproc < 1 || nproc > NPROCS || ms < 1 || kind >= NLTKIND){
+    printf(2, "usage: lockbench [nproc [ms [kind [cs]]]], nproc <= %d\n",
+           NPROCS);
+    exit();
+  }
+
+  if((id = shm_open(KEY, sizeof(struct shared))) < 0)
+    fail("lockbench", "shm_open");
+  if((sh = shm_attach(id)) == (struct shared*)-1)
+    fail("lockbench", "shm_attach");
+
+  ncs = sizeof(cslens) / sizeof(cslens[0]);
+  if(argc > 4){
+    cslens[0] = atoi(argv[4]);
+    ncs = 1;
+  }
+  for(c = 0; c < ncs; c++)
+    for(k = 0; k < NLTKIND; k++)
+      if(kind < 0 || k == kind)
+        run(nproc, ms, k, cslens[c]);
+
+  shm_detach(sh);
+  exit();
+}
@@ -0,0 +1,159 @@
+// Lock microbenchmark.
+//
+// Every process in locktest() contends for the one lock of the
+// kind it asked for, holding it for a critical section that
+// writes a shared counter cs times, and records how long each
+// acquisition waited.  Besides the kernel's own locks there are
+// two candidates to compare them with: a ticket lock, which
+// hands the lock over in arrival order, and an MCS lock, where
+// each waiter spins on its own node instead of the lock word.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "x86.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "reentrantlock.h"
+#include "locktest.h"
+
+struct ticketlock {
+  volatile uint next;   // ticket for the next arrival
+  volatile uint owner;  // ticket being served
+};
+
+struct mcsnode {
+  struct mcsnode *volatile next;
+  volatile int locked;
+};
+
+struct mcslock {
+  struct mcsnode *volatile tail;  // last waiter, 0 if free
+};
+
+static struct {
+  struct spinlock spin;
+  struct ticketlock ticket;
+  struct mcslock mcs;
+  struct sleeplock sleep;
+  struct reentrantlock reentrant;
+  volatile int inside;  // holders in the critical section
+  volatile uint counter;
+} lt;
+
+static void
+ticketacquire(struct ticketlock *lk)
+{
+  uint t;
+
+  pushcli();
+  t = __sync_fetch_and_add(&lk->next, 1);
+  while(lk->owner != t)
+    asm volatile("pause");
+  __sync_synchronize();
+}
+
+static void
+ticketrelease(struct ticketlock *lk)
+{
+  __sync_synchronize();
+  lk->owner++;
+  popcli();
+}
+
+static void
+mcsacquire(struct mcslock *lk, struct mcsnode *n)
+{
+  struct mcsnode *pred;
+
+  pushcli();
+  n->next = 0;
+  n->locked = 1;
+  pred = (struct mcsnode*)xchg((volatile uint*)&lk->tail, (uint)n);
+  if(pred){
+    pred->next = n;
+    while(n->locked)
+      asm volatile("pause");
+  }
+  __sync_synchronize();
+}
+
+static void
+mcsrelease(struct mcslock *lk, struct mcsnode *n)
+{
+  __sync_synchronize();
+  if(n->next == 0){
+    if(__sync_bool_compare_and_swap(&lk->tail, n, 0)){
+      popcli();
+      return;
+    }
+    while(n->next == 0)  // a waiter is linking itself in
+      asm volatile("pause");
+  }
+  n->next->locked = 0;
+  popcli();
+}
+
+void
+locktestinit(void)
+{
+  initlock(&lt.spin, "locktest");
+  initsleeplock(&lt.sleep, "locktest");
+  initreentrantlock(&lt.reentrant);
+}
+
+// Run critical sections on lock kind for ms milliseconds and
+// put what was seen in *r, which the caller has checked.
+int
+locktest(int kind, int ms, int cs, struct ltresult *r)
+{
+  struct mcsnode node;
+  uint64 start, end, t;
+  uint i, b;
+
+  if(kind < 0 || kind >= NLTKIND || ms <= 0 || ms > 10000 || cs < 0 ||
+     tsckhz == 0)
+    return -1;
+  memset(r, 0, sizeof(*r));
+  end = rdtsc() + (uint64)ms * tsckhz;
+  while((start = rdtsc()) < end && !myproc()->killed){
+    switch(kind){
+    case LT_SPIN:      acquire(&lt.spin); break;
+    case LT_TICKET:    ticketacquire(&lt.ticket); break;
+    case LT_MCS:       mcsacquire(&lt.mcs, &node); break;
+    case LT_SLEEP:     acquiresleep(&lt.sleep); break;
+    case LT_REENTRANT:
+      acquirereentrant(&lt.reentrant);
+      acquirereentrant(&lt.reentrant);
+      break;
+    }
+    t = rdtsc() - start;
+
+    if(lt.inside++ != 0)
+      r->errors++;
+    for(i = 0; i < cs; i++)
+      lt.counter++;
+    lt.inside--;
+
+    switch(kind){
+    case LT_SPIN:      release(&lt.spin); break;
+    case LT_TICKET:    ticketrelease(&lt.ticket); break;
+    case LT_MCS:       mcsrelease(&lt.mcs, &node); break;
+    case LT_SLEEP:     releasesleep(&lt.sleep); break;
+    case LT_REENTRANT:
+      releasereentrant(&lt.reentrant);
+      releasereentrant(&lt.reentrant);
+      break;
+    }
+
+    for(b = 0; b < NLTLAT-1 && (t >> (b+1)) != 0; b++)
+      ;
+    r->ops++;
+    r->wait += t;
+    r->lat[b]++;
+  }
+  return 0;
+}
@@ -0,0 +1,18 @@
+// Lock microbenchmark, as run by locktest().
+
+#define LT_SPIN       0   // spinlock: acquire() and release()
+#define LT_TICKET     1   // ticket lock
+#define LT_MCS        2   // MCS queue lock
+#define LT_SLEEP      3   // sleeplock
+#define LT_REENTRANT  4   // reentrantlock, taken twice
+#define NLTKIND       5
+
+#define NLTLAT        32  // buckets of the wait histogram
+
+// What one process saw.
+struct ltresult {
+  uint ops;          // critical sections run
+  uint errors;       // times another holder was found inside
+  uint64 wait;       // TSC cycles spent acquiring
+  uint lat[NLTLAT];  // acquisitions by wait: bucket b < 2^(b+1) cycles
+};
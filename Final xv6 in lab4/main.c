@@ -29,8 +29,15 @@ main(void)
   uartinit();      // serial port
   pinit();         // process table
   tvinit();        // trap vectors
+  traceinit();     // event tracing
+  profinit();      // sampling profiler
   binit();         // buffer cache
+  textinit();      // shared executable and file pages
+  shminit();       // shared-memory segments
+  vdsoinit();      // pages shared with user space
   fileinit();      // file table
+  procfsinit();    // kernel statistics in /proc
+  locktestinit();  // lock microbenchmark
   ideinit();       // disk 
   startothers();   // start other processors
   kinit2(P2V(4*1024*1024), P2V(PHYSTOP)); // must come after startothers()
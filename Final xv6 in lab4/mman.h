@@ -0,0 +1,8 @@
+#define PROT_READ     0x1
+#define PROT_WRITE    0x2
+
+#define MAP_SHARED    0x01  // writes go back to the file
+#define MAP_PRIVATE   0x02  // writes stay in this process
+#define MAP_ANONYMOUS 0x20  // zero-filled, no file
+
+#define MAP_FAILED    ((void*)-1)
@@ -0,0 +1,149 @@
+// Exercise mmap(): file and anonymous regions, MAP_SHARED
+// writeback, fork(), and a read()-versus-mmap() word count.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "mman.h"
+
+#define NPASS 50
+
+char buf[512];
+
+int
+words(char *p, int n)
+{
+  int i, w, inword;
+
+  w = inword = 0;
+  for(i = 0; i < n; i++){
+    if(strchr(" \r\t\n\v", p[i]))
+      inword = 0;
+    else if(!inword){
+      w++;
+      inword = 1;
+    }
+  }
+  return w;
+}
+
+void
+bench(char *file)
+{
+  int fd, i, n, wr, wm, start, tr, tm;
+  struct stat st;
+  char *p;
+
+  if((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &st) < 0)
+    fail("mmaptest", "open bench file");
+  close(fd);
+
+  start = uptime();
+  for(i = 0; i < NPASS; i++){
+    // Like wc, a block at a time.  Words split across blocks
+    // are counted twice, which is fine for timing.
+    fd = open(file, O_RDONLY);
+    wr = 0;
+    while((n = read(fd, buf, sizeof(buf))) > 0)
+      wr += words(buf, n);
+    close(fd);
+  }
+  tr = uptime() - start;
+
+  start = uptime();
+  for(i = 0; i < NPASS; i++){
+    fd = open(file, O_RDONLY);
+    if((p = mmap(0, st.size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+      fail("mmaptest", "bench mmap");
+    close(fd);
+    wm = words(p, st.size);
+    munmap(p, st.size);
+  }
+  tm = uptime() - start;
+
+  printf(1, "mmaptest: %s, %d bytes %d words, %d passes: "
+         "read %d ticks, mmap %d ticks\n", file, st.size, wm, NPASS, tr, tm);
+  if(wr < wm)
+    fail("mmaptest", "word counts");
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, fd2, pid, i;
+  char *p, *q;
+  struct stat st;
+
+  // Anonymous memory is zeroed and private to fork children.
+  p = mmap(0, 3*4096, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if(p == MAP_FAILED)
+    fail("mmaptest", "anonymous mmap");
+  if(p[0] != 0 || p[3*4096-1] != 0)
+    fail("mmaptest", "zero fill");
+  p[5000] = 'x';
+  if((pid = fork()) == 0){
+    p[5000] = 'y';
+    exit();
+  }
+  wait();
+  if(p[5000] != 'x')
+    fail("mmaptest", "private after fork");
+
+  // Shared anonymous memory is seen by the child's writes.
+  q = mmap(0, 4096, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+  if(q == MAP_FAILED)
+    fail("mmaptest", "shared anonymous mmap");
+  if((pid = fork()) == 0){
+    q[10] = 'c';
+    exit();
+  }
+  wait();
+  if(q[10] != 'c')
+    fail("mmaptest", "shared after fork");
+
+  // Punch a hole in the middle of p; the ends stay.
+  if(munmap(p + 4096, 4096) < 0)
+    fail("mmaptest", "munmap middle");
+  if(p[5000-4096] != 0 || p[2*4096] != 0)
+    fail("mmaptest", "ends after munmap");
+  if(munmap(p, 3*4096) < 0 || munmap(q, 4096) < 0)
+    fail("mmaptest", "munmap");
+
+  // Read-only mappings cannot be written, even by the kernel.
+  fd = open("mmaptest.tmp", O_CREATE|O_RDWR);
+  for(i = 0; i < sizeof(buf); i++)
+    buf[i] = 'a' + i % 26;
+  for(i = 0; i < 6; i++)
+    write(fd, buf, sizeof(buf));
+  p = mmap(0, 8192, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(p == MAP_FAILED || p[0] != 'a' || p[27] != 'b')
+    fail("mmaptest", "file mmap");
+  if(p[6*512] != 0)
+    fail("mmaptest", "zero past end of file");
+  fd2 = open("mmaptest.tmp", O_RDONLY);
+  if(read(fd2, p, 10) >= 0)
+    fail("mmaptest", "read into read-only mapping");
+  close(fd2);
+  munmap(p, 8192);
+
+  // MAP_SHARED writes reach the file, but do not grow it.
+  p = mmap(0, 8192, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if(p == MAP_FAILED)
+    fail("mmaptest", "shared file mmap");
+  p[1] = 'Z';
+  p[4000] = 'Q';
+  munmap(p, 8192);
+  close(fd);
+  fd = open("mmaptest.tmp", O_RDONLY);
+  if(read(fd, buf, 2) != 2 || buf[1] != 'Z')
+    fail("mmaptest", "writeback");
+  if(fstat(fd, &st) < 0 || st.size != 6*512)
+    fail("mmaptest", "file size after writeback");
+  close(fd);
+  unlink("mmaptest.tmp");
+
+  bench(argc > 1 ? argv[1] : "README");
+  printf(1, "mmaptest: ok\n");
+  exit();
+}
@@ -10,8 +10,15 @@
 #define CR0_PG          0x80000000      // Paging
 
 #define CR4_PSE         0x00000010      // Page size extension
+#define CR4_PGE         0x00000080      // Page global enable
 
-// various segment selectors.
+// Model-specific registers used by sysenter
+#define MSR_SYSENTER_CS  0x174          // Kernel %cs; %ss is the next segment
+#define MSR_SYSENTER_ESP 0x175          // Kernel %esp
+#define MSR_SYSENTER_EIP 0x176          // Kernel entry point
+
+// various segment selectors.  sysenter and sysexit need
+// them in this order.
 #define SEG_KCODE 1  // kernel code
 #define SEG_KDATA 2  // kernel data+stack
 #define SEG_UCODE 3  // user code
@@ -83,6 +90,7 @@ struct segdesc {
 #define NPDENTRIES      1024    // # directory entries per page directory
 #define NPTENTRIES      1024    // # PTEs per page table
 #define PGSIZE          4096    // bytes mapped by a page
+#define SPGSIZE         (PGSIZE*NPTENTRIES)  // bytes mapped by a superpage
 
 #define PTXSHIFT        12      // offset of PTX in a linear address
 #define PDXSHIFT        22      // offset of PDX in a linear address
@@ -94,7 +102,14 @@ struct segdesc {
 #define PTE_P           0x001   // Present
 #define PTE_W           0x002   // Writeable
 #define PTE_U           0x004   // User
+#define PTE_A           0x020   // Accessed
+#define PTE_D           0x040   // Dirty
 #define PTE_PS          0x080   // Page Size
+#define PTE_G           0x100   // Global: kept in the TLB across %cr3 loads
+#define PTE_COW         0x800   // Shared; copy before writing (software bit)
+
+// Page fault error code flags
+#define FEC_WR          0x2     // Fault caused by a write
 
 // Address in page table or page directory entry
 #define PTE_ADDR(pte)   ((uint)(pte) & ~0xFFF)
@@ -0,0 +1,77 @@
+// wc that maps each file instead of reading it.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "mman.h"
+
+char buf[512];
+
+void
+count(char *p, int n, int *l, int *w, int *inword)
+{
+  int i;
+
+  for(i=0; i<n; i++){
+    if(p[i] == '\n')
+      (*l)++;
+    if(strchr(" \r\t\n\v", p[i]))
+      *inword = 0;
+    else if(!*inword){
+      (*w)++;
+      *inword = 1;
+    }
+  }
+}
+
+void
+wc(int fd, char *name)
+{
+  int n, l, w, c, inword;
+  struct stat st;
+  char *p;
+
+  l = w = c = 0;
+  inword = 0;
+  if(fstat(fd, &st) < 0 || st.type != T_FILE){
+    // Pipes and devices cannot be mapped.
+    while((n = read(fd, buf, sizeof(buf))) > 0){
+      count(buf, n, &l, &w, &inword);
+      c += n;
+    }
+    if(n < 0){
+      printf(1, "wc: read error\n");
+      exit();
+    }
+  } else if(st.size > 0){
+    if((p = mmap(0, st.size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+      printf(1, "wc: mmap error\n");
+      exit();
+    }
+    count(p, st.size, &l, &w, &inword);
+    c = st.size;
+    munmap(p, st.size);
+  }
+  printf(1, "%d %d %d %s\n", l, w, c, name);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i;
+
+  if(argc <= 1){
+    wc(0, "");
+    exit();
+  }
+
+  for(i = 1; i < argc; i++){
+    if((fd = open(argv[i], 0)) < 0){
+      printf(1, "wc: cannot open %s\n", argv[i]);
+      exit();
+    }
+    wc(fd, argv[i]);
+    close(fd);
+  }
+  exit();
+}
@@ -10,5 +10,19 @@
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       1000  // size of file system in blocks
+#define FSSIZE       4000  // size of file system in blocks
 #define NSCHEDQUEUE   3  // number of scheduling queues
+#define RRTICKS      30  // ticks per turn of the RR queue
+#define SJFTICKS     20  // ticks per turn of the SJF queue
+#define FCFSTICKS    10  // ticks per turn of the FCFS queue
+#define RRQUANTUM     5  // ticks per RR time slice
+#define NSPAWNFD      3  // descriptors handed to a spawned child
+#define NEXECSEG      4  // demand-paged ELF segments per process
+#define NTEXTPG     128  // executable pages in the shared text cache
+#define NMAPPG       64  // pages of MAP_SHARED files in memory
+#define NVMA         16  // mmap() regions per process
+#define NSHM          8  // shared-memory segments
+#define NSHMPG       32  // pages per shared-memory segment
+#define NTRACE      512  // trace records kept per CPU
+#define NPROFSAMPLE 1024  // profiler samples kept per CPU
+#define NLOCKSTAT    32  // lock names with contention counted
@@ -6,6 +6,10 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "traps.h"
+#include "trace.h"
+#include "rusage.h"
+#include "procinfo.h"
 
 struct
 {
@@ -22,6 +26,8 @@ extern void forkret(void);
 extern void trapret(void);
 
 static void wakeup1(void *chan);
+static void makerunnable(struct proc *p);
+static void switchin(struct proc *p);
 
 void pinit(void)
 {
@@ -118,11 +124,14 @@ found:
   p->context->eip = (uint)forkret;
 
   // Initialize number of each system call
-  memset(p->syscall_invokes, 0, sizeof(p->syscall_invokes));
+  memset(p->sysstat, 0, sizeof(p->sysstat));
 
   // Initialize number of system calls
   p->syscalls_count = 0;
 
+  p->utime = p->stime = 0;
+  memset(p->qwait, 0, sizeof(p->qwait));
+
   // Default scheduling queue except init and shell
   if (p->pid == 1 ||
       p->pid == 2)
@@ -178,28 +187,47 @@ void userinit(void)
   // because the assignment might not be atomic.
   acquire(&ptable.lock);
 
-  p->state = RUNNABLE;
+  makerunnable(p);
 
   release(&ptable.lock);
 }
 
 // Grow current process's memory by n bytes.
+// Growing only reserves the address range; pages are
+// allocated on first touch by uvmfault().
 // Return 0 on success, -1 on failure.
 int growproc(int n)
 {
+  int i;
   uint sz;
+  struct execseg *seg;
   struct proc *curproc = myproc();
 
   sz = curproc->sz;
   if (n > 0)
   {
-    if ((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    if (sz + n < sz || sz + n > MMAPBASE)
       return -1;
+    sz += n;
   }
   else if (n < 0)
   {
     if ((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
+    // Memory given back must not be paged in from the
+    // executable again if the process later regrows.
+    for (i = 0; i < curproc->nexecseg; i++)
+    {
+      seg = &curproc->execseg[i];
+      if (seg->vaddr >= sz)
+        seg->memsz = seg->filesz = 0;
+      else if (seg->vaddr + seg->memsz > sz)
+      {
+        seg->memsz = sz - seg->vaddr;
+        if (seg->filesz > seg->memsz)
+          seg->filesz = seg->memsz;
+      }
+    }
   }
   curproc->sz = sz;
   switchuvm(curproc);
@@ -229,9 +257,21 @@ int fork(void)
     np->state = UNUSED;
     return -1;
   }
+  if (vmacopy(np) < 0)
+  {
+    freevm(np->pgdir);
+    kfree(np->kstack);
+    np->kstack = 0;
+    np->state = UNUSED;
+    return -1;
+  }
+  shmfork(np);
   np->sz = curproc->sz;
   np->parent = curproc;
   *np->tf = *curproc->tf;
+  np->exe = curproc->exe ? idup(curproc->exe) : 0;
+  np->nexecseg = curproc->nexecseg;
+  memmove(np->execseg, curproc->execseg, sizeof(curproc->execseg));
 
   // Clear %eax so that fork returns 0 in the child.
   np->tf->eax = 0;
@@ -251,7 +291,87 @@ int fork(void)
 
   acquire(&ptable.lock);
 
-  np->state = RUNNABLE;
+  makerunnable(np);
+
+  release(&ptable.lock);
+
+  return pid;
+}
+
+// Create a new process running the program at path, without
+// first duplicating the caller's address space the way fork()
+// followed by exec() would.  If fdmap is non-zero, the child's
+// descriptors 0..NSPAWNFD-1 are dups of the caller's fdmap[i]
+// (-1 leaves the slot closed) and nothing else is inherited;
+// otherwise the child inherits every open descriptor.
+int spawn(char *path, char **argv, int *fdmap)
+{
+  int i, fd, pid;
+  struct uimage img;
+  struct proc *np;
+  struct proc *curproc = myproc();
+
+  if (fdmap)
+  {
+    for (i = 0; i < NSPAWNFD; i++)
+    {
+      fd = fdmap[i];
+      if (fd != -1 && (fd < 0 || fd >= NOFILE || curproc->ofile[fd] == 0))
+        return -1;
+    }
+  }
+
+  if (loadimage(path, argv, &img) < 0)
+    return -1;
+
+  // Allocate process.
+  if ((np = allocproc()) == 0)
+  {
+    freeimage(&img);
+    return -1;
+  }
+
+  np->pgdir = img.pgdir;
+  np->sz = img.sz;
+  np->exe = img.exe;
+  np->nexecseg = img.nexecseg;
+  memmove(np->execseg, img.execseg, sizeof(img.execseg));
+  np->parent = curproc;
+  memset(np->tf, 0, sizeof(*np->tf));
+  np->tf->cs = (SEG_UCODE << 3) | DPL_USER;
+  np->tf->ds = (SEG_UDATA << 3) | DPL_USER;
+  np->tf->es = np->tf->ds;
+  np->tf->ss = np->tf->ds;
+  np->tf->eflags = FL_IF;
+  np->tf->esp = img.sp;
+  np->tf->eip = img.entry;
+
+  if (fdmap)
+  {
+    for (i = 0; i < NSPAWNFD; i++)
+      if (fdmap[i] != -1)
+        np->ofile[i] = filedup(curproc->ofile[fdmap[i]]);
+  }
+  else
+  {
+    for (i = 0; i < NOFILE; i++)
+      if (curproc->ofile[i])
+        np->ofile[i] = filedup(curproc->ofile[i]);
+  }
+  np->cwd = idup(curproc->cwd);
+
+  safestrcpy(np->name, img.name, sizeof(np->name));
+
+  pid = np->pid;
+
+  // A spawned shell command lands where exec() would have moved
+  // the shell's fork: FCFS.
+  if (curproc->pid == 2)
+    np->schedqueue = FCFS;
+
+  acquire(&ptable.lock);
+
+  makerunnable(np);
 
   release(&ptable.lock);
 
@@ -270,6 +390,10 @@ void exit(void)
   if (curproc == initproc)
     panic("init exiting");
 
+  // Write back and drop mmap() regions while the files are open.
+  munmap(MMAPBASE, VDSOBASE - MMAPBASE);
+  shmexit();
+
   // Close all open files.
   for (fd = 0; fd < NOFILE; fd++)
   {
@@ -282,8 +406,11 @@ void exit(void)
 
   begin_op();
   iput(curproc->cwd);
+  if (curproc->exe)
+    iput(curproc->exe);
   end_op();
   curproc->cwd = 0;
+  curproc->exe = 0;
 
   acquire(&ptable.lock);
 
@@ -362,50 +489,75 @@ rand()
   return randstate;
 }
 
+// CPU accounting, in TSC cycles.  p->tscmark is when p last
+// started running in user space, running in the kernel, or
+// waiting to run.  Charge p for the time since then: to utime
+// if user is set, else stime.
+void chargetime(struct proc *p, int user)
+{
+  uint64 now;
+
+  pushcli();
+  now = rdtsc();
+  if (user)
+    p->utime += now - p->tscmark;
+  else
+    p->stime += now - p->tscmark;
+  p->tscmark = now;
+  popcli();
+}
+
+// Charge runnable p for waiting in its queue until now, when
+// it starts running.  Caller holds ptable.lock.
+static void switchin(struct proc *p)
+{
+  uint64 now = rdtsc();
+
+  p->qwait[p->schedqueue] += now - p->tscmark;
+  p->tscmark = now;
+}
+
 // Switch to chosen process.  It is the process's job
 // to release ptable.lock and then reacquire it
 // before jumping back to us.
 void switch_to_chosen_process(struct proc *p, struct cpu *c)
 {
+  trace(TR_SWITCH, 0, p->pid, 0, p->name);
   c->proc = p;
   switchuvm(p);
+  switchin(p);
   p->state = RUNNING;
   p->wait_time = 0;
+  c->nswitch++;
 
   swtch(&(c->scheduler), p->context);
-  switchkvm();
+  // Stay on p's page table: the kernel half is the same in all
+  // of them, and the next switchuvm() replaces it anyway.
 
   // Process is done running for now.
   // It should have changed its p->state before coming back.
   c->proc = 0;
 }
 
-// PAGEBREAK: 42
-//  Per-CPU process scheduler.
-//  Each CPU calls scheduler() after setting itself up.
-//  Scheduler never returns.  It loops, doing:
-//   - choose a process to run
-//   - swtch to start running that process
-//   - eventually that process transfers control
-//       via swtch back to the scheduler.
-void scheduler(void)
+// Choose the next process for CPU c from its current queue,
+// moving on to the next queue whenever one is empty.  Returns
+// 0 if nothing at all is runnable.  Caller holds ptable.lock.
+static struct proc *
+pickproc(struct cpu *c)
 {
-  struct proc *p, *nextp, *nextrrp = ptable.proc, *longestjob;
-  struct cpu *c = mycpu();
-  c->proc = 0;
+  struct proc *p, *nextp, *longestjob;
+  int i;
 
-  for (;;)
+  for (i = 0; i < NSCHEDQUEUE; i++)
   {
-    // Enable interrupts on this processor.
-    sti();
-
     nextp = 0;
-    acquire(&ptable.lock);
     switch (c->schedqueue)
     {
     case RR:
       // Loop over process table looking for process to run.
-      p = nextrrp;
+      if (c->nextrr == 0)
+        c->nextrr = ptable.proc;
+      p = c->nextrr;
       do
       {
         if (p->state != RUNNABLE || p->schedqueue != RR)
@@ -419,9 +571,9 @@ void scheduler(void)
 
         if (++p == &ptable.proc[NPROC])
           p = ptable.proc;
-        nextrrp = p;
+        c->nextrr = p;
         break;
-      } while (p != nextrrp);
+      } while (p != c->nextrr);
       break;
 
     case SJF:
@@ -455,17 +607,104 @@ void scheduler(void)
       }
       break;
     }
+    if (nextp)
+    {
+      if (i > 0)
+        armtimer(); // the new queue's turn starts now
+      return nextp;
+    }
 
     // start next queue if queue is empty
-    if (nextp == 0)
+    trace(TR_QUEUE, 0, c->schedqueue, (c->schedqueue + 1) % NSCHEDQUEUE, 0);
+    c->schedqueue = (c->schedqueue + 1) % NSCHEDQUEUE;
+    c->queueticks = 0;
+  }
+  return 0;
+}
+
+// Set this CPU's timer for the next tick at which trap() has
+// scheduling work to do: the end of the current queue's turn
+// or of an RR time slice.  Ticks in between would do nothing,
+// so they are skipped.  CPU 0 keeps ticking periodically: it
+// keeps time, wakes sleepers and ages processes for everyone.
+// Interrupts must be off.
+void armtimer(void)
+{
+  struct cpu *c = mycpu();
+  int n;
+
+  if (cpuid() == 0)
+    return;
+  switch (c->schedqueue)
+  {
+  case RR:
+    n = RRTICKS - c->queueticks;
+    if (RRQUANTUM - c->queueticks % RRQUANTUM < n)
+      n = RRQUANTUM - c->queueticks % RRQUANTUM;
+    break;
+  case SJF:
+    n = SJFTICKS - c->queueticks;
+    break;
+  default:
+    n = FCFSTICKS - c->queueticks;
+    break;
+  }
+  if (n < 1 || profiling)
+    n = 1; // the profiler samples every tick
+  c->armed = n;
+  lapiconeshot(n);
+}
+
+// PAGEBREAK: 42
+//  Per-CPU process scheduler.
+//  Each CPU calls scheduler() after setting itself up.
+//  Scheduler never returns.  It loops, doing:
+//   - choose a process to run
+//   - swtch to start running that process
+//   - eventually that process transfers control
+//       via swtch back to the scheduler.
+//  Processes giving up the CPU usually switch straight to the
+//  next one (see sched), so the scheduler only runs when the
+//  CPU has had nothing to do.
+void scheduler(void)
+{
+  struct proc *p;
+  struct cpu *c = mycpu();
+  uint idlestart;
+  c->proc = 0;
+
+  for (;;)
+  {
+    // Enable interrupts on this processor.
+    sti();
+
+    acquire(&ptable.lock);
+    if ((p = pickproc(c)) != 0)
     {
-      c->schedqueue = (c->schedqueue + 1) % NSCHEDQUEUE;
-      c->queueticks = 0;
+      switch_to_chosen_process(p, c);
+      release(&ptable.lock);
+      continue;
     }
-    else
-      switch_to_chosen_process(nextp, c);
 
+    // Nothing to run: halt until the next interrupt instead of
+    // spinning on ptable.lock.  idle is set under the lock, so a
+    // makerunnable() that misses this scan will send an IPI; and
+    // sti takes effect only after hlt starts, so that IPI cannot
+    // slip in before the CPU halts.  Only CPU 0's timer keeps
+    // running meanwhile.
+    c->idle = 1;
+    idlestart = ticks;
+    if (cpuid() != 0)
+      lapiconeshot(0);
+    pushcli();
     release(&ptable.lock);
+    sti();
+    hlt();
+    cli();
+    c->idle = 0;
+    c->idleticks += ticks - idlestart;
+    armtimer();
+    popcli();
   }
 }
 
@@ -479,7 +718,8 @@ void scheduler(void)
 void sched(void)
 {
   int intena;
-  struct proc *p = myproc();
+  struct proc *p = myproc(), *np;
+  struct cpu *c;
 
   if (!holding(&ptable.lock))
     panic("sched ptable.lock");
@@ -490,7 +730,35 @@ void sched(void)
   if (readeflags() & FL_IF)
     panic("sched interruptible");
   intena = mycpu()->intena;
-  swtch(&p->context, mycpu()->scheduler);
+
+  // Switch straight to the next process if there is one,
+  // rather than through the scheduler's context.
+  c = mycpu();
+  np = pickproc(c);
+  chargetime(p, 0);
+  if (np == p)
+  {
+    // p yielded, but is still the best choice.
+    switchin(p);
+    p->state = RUNNING;
+    p->wait_time = 0;
+  }
+  else if (np)
+  {
+    trace(TR_SWITCH, p->pid, np->pid, p->state, np->name);
+    c->proc = np;
+    switchuvm(np);
+    switchin(np);
+    np->state = RUNNING;
+    np->wait_time = 0;
+    c->nswitch++;
+    swtch(&p->context, np->context);
+  }
+  else
+  {
+    trace(TR_SWITCH, p->pid, 0, p->state, 0);
+    swtch(&p->context, c->scheduler);
+  }
   mycpu()->intena = intena;
 }
 
@@ -520,13 +788,13 @@ void age_processes(void)
         p->wait_time = 0;
         p->schedqueue = SJF;
         p->arraival = ticks;
-        cprintf("pid:%d perv_queue:FCFS new_queue:SJF\n", p->pid);
+        trace(TR_QUEUE, p->pid, FCFS, SJF, p->name);
         break;
       case SJF:
         p->wait_time = 0;
         p->schedqueue = RR;
         p->arraival = ticks;
-        cprintf("pid:%d perv_queue:SJF new_queue:RR\n", p->pid);
+        trace(TR_QUEUE, p->pid, SJF, RR, p->name);
         break;
       default:
         break;
@@ -621,7 +889,45 @@ wakeup1(void *chan)
 
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
     if (p->state == SLEEPING && p->chan == chan)
-      p->state = RUNNABLE;
+      makerunnable(p);
+}
+
+// Make p runnable.  If some other CPU is halted in scheduler()
+// with nothing to do, kick it with an IPI so that it picks p up
+// now rather than at its next timer interrupt.  Failing that,
+// RR work preempts a CPU (maybe this one) running SJF or FCFS
+// work, instead of waiting out that queue's ticks.
+// The ptable lock must be held.
+static void
+makerunnable(struct proc *p)
+{
+  struct cpu *c;
+
+  p->state = RUNNABLE;
+  p->tscmark = rdtsc();  // start waiting
+  trace(TR_WAKEUP, p->pid, p->schedqueue, 0, p->name);
+  for (c = cpus; c < cpus + ncpu; c++)
+  {
+    if (c->idle && c != mycpu())
+    {
+      // No longer idle as far as other wakeups go, so that the
+      // next one kicks a different CPU.
+      c->idle = 0;
+      lapicipi(c->apicid, T_IRQ0 + IRQ_RESCHED);
+      return;
+    }
+  }
+  if (p->schedqueue != RR)
+    return;
+  for (c = cpus; c < cpus + ncpu; c++)
+  {
+    if (c->proc && c->proc->schedqueue != RR && !c->preempt)
+    {
+      c->preempt = 1;
+      lapicipi(c->apicid, T_IRQ0 + IRQ_RESCHED);
+      return;
+    }
+  }
 }
 
 // Wake up all processes sleeping on chan.
@@ -647,7 +953,7 @@ int kill(int pid)
       p->killed = 1;
       // Wake process from sleep if necessary.
       if (p->state == SLEEPING)
-        p->state = RUNNABLE;
+        makerunnable(p);
       release(&ptable.lock);
       return 0;
     }
@@ -704,45 +1010,21 @@ void create_palindrome(int num)
   cprintf("%d\n", ans);
 }
 
-int sort_syscalls(int pid)
+// Copy the call counts of process pid into count[MAX_SYSCALLS],
+// so that they can be sorted and printed without ptable.lock.
+static int
+syscallcounts(int pid, uint *count)
 {
-  int i, j, tmp_num, last_one = 0;
-  char *tmp_name;
   struct proc *p;
+  int i;
 
-  // Find the process with the given PID
   acquire(&ptable.lock);
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
-    if (p->pid == pid)
+    if (p->pid == pid && p->state != UNUSED)
     {
-      // Sort system calls
-      for (i = 0; i < p->syscalls_count - 1; i++)
-      {
-        for (j = 0; j < p->syscalls_count - i - 1; j++)
-        {
-          if (p->syscall_num[j] > p->syscall_num[j + 1])
-          {
-            tmp_num = p->syscall_num[j];
-            tmp_name = p->syscall_name[j];
-
-            p->syscall_num[j] = p->syscall_num[j + 1];
-            p->syscall_name[j] = p->syscall_name[j + 1];
-
-            p->syscall_num[j + 1] = tmp_num;
-            p->syscall_name[j + 1] = tmp_name;
-          }
-        }
-      }
-
-      cprintf("System calls for process %d:\n", pid);
-      for (i = 0; i < p->syscalls_count - 1; i++)
-        if (p->syscall_num[i] != last_one)
-        {
-          cprintf("Syscall #%d: %s\n", p->syscall_num[i], p->syscall_name[i]);
-          last_one = p->syscall_num[i];
-        }
-
+      for (i = 0; i < MAX_SYSCALLS; i++)
+        count[i] = p->sysstat[i].count;
       release(&ptable.lock);
       return 0;
     }
@@ -751,55 +1033,111 @@ int sort_syscalls(int pid)
   return -1;
 }
 
+int sort_syscalls(int pid)
+{
+  uint count[MAX_SYSCALLS];
+  int i;
+
+  if (syscallcounts(pid, count) < 0)
+    return -1;
+
+  // The counts are indexed by number, so already sorted.
+  cprintf("System calls for process %d:\n", pid);
+  for (i = 0; i < MAX_SYSCALLS; i++)
+    if (count[i] > 0)
+      cprintf("Syscall #%d: %s (%d calls)\n", i, syscallname(i), count[i]);
+  return 0;
+}
+
 int get_most_invoked_syscall(int pid)
 {
-  char *syscall_name = "";
-  int syscall_invokes = 0;
-  int syscall_num = 0;
+  uint count[MAX_SYSCALLS];
+  int i, syscall_num = 0;
+
+  if (syscallcounts(pid, count) < 0)
+    return -1;
+
+  for (i = 1; i < MAX_SYSCALLS; i++)
+    if (count[i] > count[syscall_num])
+      syscall_num = i;
+  if (count[syscall_num] == 0)
+    return -1;
+  cprintf("Most invoked syscall for process %d is %s with %d invokes\n", pid,
+          syscallname(syscall_num), count[syscall_num]);
+  return syscall_num;
+}
+
+// Print how long process pid's calls of each system call
+// took, as a histogram of TSC cycles.
+int syscall_latency(int pid)
+{
+  struct sysstat st;
   struct proc *p;
-  acquire(&ptable.lock);
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  uint count[MAX_SYSCALLS];
+  uint mean;
+  int i, b, found;
+
+  if (syscallcounts(pid, count) < 0)
+    return -1;
+
+  cprintf("System call latency for process %d, in TSC cycles (%d per ms):\n",
+          pid, tsckhz);
+  for (i = 0; i < MAX_SYSCALLS; i++)
   {
-    if (p->pid == pid)
+    if (count[i] == 0)
+      continue;
+    found = 0;
+    acquire(&ptable.lock);
+    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
     {
-      for (int i = 0; i < p->syscalls_count; i++)
-      {
-        if (syscall_invokes <= p->syscall_invokes[p->syscall_num[i]])
-        {
-
-          syscall_invokes = p->syscall_invokes[p->syscall_num[i]];
-          syscall_name = p->syscall_name[i];
-          syscall_num = p->syscall_num[i];
-        }
-      }
-      if (syscall_invokes > 0)
+      if (p->pid == pid && p->state != UNUSED)
       {
-        cprintf("Most invoked syscall for process %d is %s with %d invokes\n", p->pid, syscall_name,
-                syscall_invokes);
-        release(&ptable.lock);
-        return syscall_num;
+        st = p->sysstat[i];
+        found = 1;
+        break;
       }
     }
+    release(&ptable.lock);
+    if (!found)
+      return -1;
+
+    // cprintf() prints signed, so cap the mean at 2^31 - 1.
+    mean = 0x7FFFFFFF;
+    if ((st.cycles >> 31) < st.count)
+      mean = divq(st.cycles, st.count, 0);
+    cprintf("%s: %d calls, mean %d\n", syscallname(i), st.count, mean);
+    for (b = 0; b < NLATBUCKET; b++)
+    {
+      if (st.lat[b] == 0)
+        continue;
+      if (b == NLATBUCKET - 1)
+        cprintf("  >= 2^%d: %d\n", 2 * b, st.lat[b]);
+      else
+        cprintf("  < 2^%d: %d\n", 2 * b + 2, st.lat[b]);
+    }
   }
-  release(&ptable.lock);
-  return -1;
+  return 0;
 }
 
 int list_all_processes()
 {
-  int p_count = 0;
-  struct proc *p;
+  struct procinfo *pi;
+  int p_count = 0, slot, n, i;
 
-  acquire(&ptable.lock);
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  if ((pi = (struct procinfo *)kalloc()) == 0)
+    return -1;
+  for (slot = 0; (n = snapprocs(pi, PGSIZE / sizeof(*pi), &slot)) > 0;)
   {
-    if (p->state == RUNNING)
+    for (i = 0; i < n; i++)
     {
-      p_count++;
-      cprintf("Process %d with %d Syscalls\n", p->pid, p->syscalls_count);
+      if (pi[i].state == RUNNING)
+      {
+        p_count++;
+        cprintf("Process %d with %d Syscalls\n", pi[i].pid, pi[i].syscalls);
+      }
     }
   }
-  release(&ptable.lock);
+  kfree((char *)pi);
   return (p_count == 0) ? -1 : 0;
 }
 
@@ -818,6 +1156,7 @@ void change_queue(int pid, int chosen_q)
     if (p->pid == pid && chosen_q != p->schedqueue)
     {
       cprintf("pid: %d perv_q:%d new_q:%d\n", pid, p->schedqueue, chosen_q);
+      trace(TR_QUEUE, pid, p->schedqueue, chosen_q, p->name);
       p->arraival = ticks;
       p->schedqueue = chosen_q;
       if (chosen_q == FCFS)
@@ -829,46 +1168,49 @@ void change_queue(int pid, int chosen_q)
 
 void processes_info(void)
 {
-  struct proc *p;
-
-  acquire(&ptable.lock);
+  static char *states[] = {
+      [UNUSED] "UNUSED",
+      [EMBRYO] "EMBRYO",
+      [SLEEPING] "SLEEPING",
+      [RUNNABLE] "RUNNABLE",
+      [RUNNING] "RUNNING",
+      [ZOMBIE] "ZOMBIE"};
+  struct procinfo *pi;
+  int slot, n, i;
+
+  if ((pi = (struct procinfo *)kalloc()) == 0)
+    return;
   cprintf(".....................................\n");
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for (slot = 0; (n = snapprocs(pi, PGSIZE / sizeof(*pi), &slot)) > 0;)
   {
-    if (p->state != UNUSED)
+    for (i = 0; i < n; i++)
     {
-      char *state_name;
-      switch (p->state)
-      {
-      case EMBRYO:
-        state_name = "EMBRYO";
-        break;
-      case SLEEPING:
-        state_name = "SLEEPING";
-        break;
-      case RUNNABLE:
-        state_name = "RUNNABLE";
-        break;
-      case RUNNING:
-        state_name = "RUNNING";
-        break;
-      case ZOMBIE:
-        state_name = "ZOMBIE";
-        break;
-      default:
-        state_name = "UNKNOWN";
-        break;
-      }
-
       cprintf("name:%s pid:%d state:%s queue:%d wait:%d confidence:%d burst time:%d consecutive:%d arrival:%d\n"
-              , p->name, p->pid, state_name, p->schedqueue,
-              p->wait_time, p->confidence, p->bursttime, p->consecutive_time, p->arraival);
+              , pi[i].name, pi[i].pid, states[pi[i].state], pi[i].queue,
+              pi[i].wait_time, pi[i].confidence, pi[i].bursttime, pi[i].consecutive, pi[i].arrival);
+      cprintf("  ms user:%d sys:%d waited RR:%d SJF:%d FCFS:%d\n",
+              pi[i].utime / 1000, pi[i].stime / 1000,
+              pi[i].wait[RR] / 1000, pi[i].wait[SJF] / 1000,
+              pi[i].wait[FCFS] / 1000);
     }
   }
   cprintf(".....................................\n");
-  release(&ptable.lock);
+  kfree((char *)pi);
 }
 
+// Print how much of its time each CPU has spent halted, and
+// how many timer interrupts it has taken.
+void cpus_info(void)
+{
+  struct cpu *c;
+  uint now;
+
+  now = ticks;
+  for (c = cpus; c < cpus + ncpu; c++)
+    cprintf("cpu:%d uptime:%d idle:%d (%d%%) timer interrupts:%d\n",
+            (int)(c - cpus), now, c->idleticks,
+            now ? c->idleticks * 100 / now : 0, c->nticks);
+}
 
 void set_bc(int pid, int bursttime, int confidence)
 {
@@ -894,4 +1236,119 @@ void get_syscalls_num(void){
   acquire(&nsyscall_lock);
   cprintf("%d\n", total_syscall);
   release(&nsyscall_lock);
-}
\ No newline at end of file
+}
+
+// Fill in ru for process pid, or the caller if pid is 0.
+int getrusage(int pid, struct rusage *ru)
+{
+  struct proc *p;
+  uint64 utime, stime, qwait[NSCHEDQUEUE];
+  int i;
+
+  if (pid == 0)
+    pid = myproc()->pid;
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  {
+    if (p->pid == pid && p->state != UNUSED)
+    {
+      utime = p->utime;
+      stime = p->stime;
+      for (i = 0; i < NSCHEDQUEUE; i++)
+        qwait[i] = p->qwait[i];
+      release(&ptable.lock);
+      ru->utime = tscus(utime);
+      ru->stime = tscus(stime);
+      for (i = 0; i < NSCHEDQUEUE; i++)
+        ru->wait[i] = tscus(qwait[i]);
+      return 0;
+    }
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
+// Snapshot the processes in ptable slots *slot onwards into
+// pi[0..max), holding ptable.lock only while copying, and
+// advance *slot past them.  Returns the number of records.
+int snapprocs(struct procinfo *pi, int max, int *slot)
+{
+  struct proc *p;
+  int n, i;
+
+  n = 0;
+  acquire(&ptable.lock);
+  for (; *slot < NPROC && n < max; (*slot)++)
+  {
+    p = &ptable.proc[*slot];
+    if (p->state == UNUSED)
+      continue;
+    pi[n].pid = p->pid;
+    pi[n].ppid = p->parent ? p->parent->pid : 0;
+    pi[n].state = p->state;
+    pi[n].queue = p->schedqueue;
+    pi[n].sz = p->sz;
+    pi[n].syscalls = p->syscalls_count;
+    pi[n].utime = tscus(p->utime);
+    pi[n].stime = tscus(p->stime);
+    for (i = 0; i < NSCHEDQUEUE; i++)
+      pi[n].wait[i] = tscus(p->qwait[i]);
+    pi[n].wait_time = p->wait_time;
+    pi[n].consecutive = p->consecutive_time;
+    pi[n].arrival = p->arraival;
+    pi[n].bursttime = p->bursttime;
+    pi[n].confidence = p->confidence;
+    safestrcpy(pi[n].name, p->name, sizeof(pi[n].name));
+    n++;
+  }
+  release(&ptable.lock);
+  return n;
+}
+
+// Copy records for up to n processes out to user address
+// buf, a page's worth of snapshot at a time.  Returns the
+// number copied.
+int getprocs(uint buf, int n)
+{
+  struct procinfo *pi;
+  int got, slot, k, max;
+
+  if ((pi = (struct procinfo *)kalloc()) == 0)
+    return -1;
+  got = 0;
+  for (slot = 0; got < n; got += k)
+  {
+    max = PGSIZE / sizeof(*pi);
+    if (max > n - got)
+      max = n - got;
+    if ((k = snapprocs(pi, max, &slot)) == 0)
+      break;
+    if (copyout(myproc()->pgdir, buf + got * sizeof(*pi), pi, k * sizeof(*pi)) < 0)
+    {
+      got = -1;
+      break;
+    }
+  }
+  kfree((char *)pi);
+  return got;
+}
+
+// Return process pid with ptable.lock held, so that it can be
+// looked at without changing underfoot, or 0 (and not held)
+// if there is none.  Release with unlockproc().
+struct proc *lockproc(int pid)
+{
+  struct proc *p;
+
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    if (p->pid == pid && p->state != UNUSED)
+      return p;
+  release(&ptable.lock);
+  return 0;
+}
+
+void unlockproc(void)
+{
+  release(&ptable.lock);
+}
@@ -19,6 +19,14 @@ struct cpu
   enum schedqueue schedqueue; // Current scheduling queue
   int queueticks;             // Numbert of ticks in the currecnt queue
   int syscallnum;             // for counting cpu syscalls
+  pde_t *pgdir;               // Process page table in %cr3, 0 if kpgdir
+  struct proc *nextrr;        // Where the next RR search starts
+  volatile int idle;          // Halted in scheduler() with nothing to run
+  volatile int preempt;       // Sent an IPI to switch to RR work
+  uint nticks;                // Timer interrupts taken
+  uint idleticks;             // Ticks spent halted
+  uint nswitch;               // Processes switched to
+  int armed;                  // Ticks the one-shot timer was set for
 };
 
 extern struct cpu cpus[NCPU];
@@ -54,7 +62,39 @@ enum procstate
   ZOMBIE
 };
 
-#define MAX_SYSCALLS 64 // Maximum number of distinct system calls to track
+#define MAX_SYSCALLS 64 // System call numbers tracked, more than the largest
+#define NLATBUCKET   16 // Buckets in a system call latency histogram
+
+// What a process's calls to one system call have cost.
+struct sysstat
+{
+  uint count;            // Calls made
+  uint64 cycles;         // TSC cycles spent in them
+  uint lat[NLATBUCKET];  // Calls taking [4^i, 4^(i+1)) cycles; the last
+                         // bucket also holds anything longer
+};
+
+// A loadable ELF segment, paged in from the executable on demand.
+struct execseg
+{
+  uint vaddr;  // First user address, page aligned
+  uint memsz;  // Bytes of memory, including bss
+  uint filesz; // Bytes backed by the file
+  uint off;    // File offset of vaddr
+};
+
+// A region of user memory set up by mmap().  Pages are filled
+// in from the file (or zeroed) when first touched.
+struct vma
+{
+  uint addr;       // First user address, page aligned; 0 if unused
+  uint len;        // Bytes, a multiple of PGSIZE
+  int prot;        // PROT_READ, PROT_WRITE
+  int flags;       // MAP_SHARED or MAP_PRIVATE, maybe MAP_ANONYMOUS
+  struct file *f;  // Mapped file, 0 if anonymous
+  uint off;        // File offset of addr
+  int shm;         // Shared-memory segment id + 1, 0 if none
+};
 
 // Per-process state
 struct proc
@@ -73,9 +113,7 @@ struct proc
   struct inode *cwd;                 // Current directory
   char name[16];                     // Process name (debugging)
   int syscalls_count;                // count number of system calls
-  int syscall_invokes[MAX_SYSCALLS]; // Array to count each system call
-  int syscall_num[MAX_SYSCALLS];     // system calls number
-  char *syscall_name[MAX_SYSCALLS];  // system calls name
+  struct sysstat sysstat[MAX_SYSCALLS]; // Calls of each system call
   enum schedqueue schedqueue;        // Current scheduling queue
   int fcfsentry;                     // Process entry number in FCFS queue
   int bursttime;                     // Burst Time of SJF
@@ -83,6 +121,16 @@ struct proc
   int arraival;                      // Attaival time
   int wait_time;                     // Wait time in a queue
   int consecutive_time;              // Num of ticks that process is running
+  struct inode *exe;                 // Executable backing the segments
+  int nexecseg;                      // Number of valid entries in execseg
+  struct execseg execseg[NEXECSEG];  // Demand-paged program segments
+  struct vma vma[NVMA];              // Regions set up by mmap()
+  uint shmheld;                      // Bit i: has shm segment i open
+  uint64 utime;                      // TSC cycles run in user space
+  uint64 stime;                      // TSC cycles run in the kernel
+  uint64 qwait[NSCHEDQUEUE];         // TSC cycles runnable, by queue
+  uint64 tscmark;                    // When utime, stime or qwait last
+                                     // caught up (see chargetime)
 };
 
 // Process memory is laid out contiguously, low addresses first:
@@ -90,3 +138,19 @@ struct proc
 //   original data and bss
 //   fixed-size stack
 //   expandable heap
+//   ...
+//   mmap() regions, from MMAPBASE up
+
+// A freshly loaded user image, built by loadimage() in exec.c
+// and committed to a process by exec() or spawn().
+struct uimage
+{
+  pde_t *pgdir; // Page table holding text, data and stack
+  uint sz;      // Size of process memory (bytes)
+  uint entry;   // Initial %eip
+  uint sp;      // Initial %esp, argv already pushed
+  char name[16];
+  struct inode *exe;
+  int nexecseg;
+  struct execseg execseg[NEXECSEG];
+};
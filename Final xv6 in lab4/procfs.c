@@ -0,0 +1,365 @@
+// Kernel statistics as files.
+//
+// init makes /proc a PROCFS device node.  Its devsw lookup
+// acts as a directory holding the global files below and a
+// directory per process, named by pid, holding the per-process
+// files.  Those inodes live only in the inode cache, on a
+// device number that is never a disk.  A file's contents are
+// generated into a page on every read, so they are current.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "proc.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+#include "dev.h"
+#include "stat.h"
+#include "procinfo.h"
+
+#define PROCFSDEV 0x7fff  // inode dev for the files below /proc
+#define NPROCFILE 8       // inums per directory: pid*NPROCFILE + file
+
+// Text being generated, at most a page.
+struct pbuf {
+  char *buf;
+  int n;
+};
+
+static void
+pputc(struct pbuf *b, int c)
+{
+  if(b->n < PGSIZE)
+    b->buf[b->n++] = c;
+}
+
+static void
+pprintint(struct pbuf *b, int xx, int base, int sign)
+{
+  static char digits[] = "0123456789abcdef";
+  char buf[16];
+  int i;
+  uint x;
+
+  if(sign && (sign = xx < 0))
+    x = -xx;
+  else
+    x = xx;
+
+  i = 0;
+  do{
+    buf[i++] = digits[x % base];
+  }while((x /= base) != 0);
+
+  if(sign)
+    buf[i++] = '-';
+
+  while(--i >= 0)
+    pputc(b, buf[i]);
+}
+
+// Like cprintf(), but into b.
+static void
+pprintf(struct pbuf *b, char *fmt, ...)
+{
+  int i, c;
+  uint *argp;
+  char *s;
+
+  argp = (uint*)(void*)(&fmt + 1);
+  for(i = 0; (c = fmt[i] & 0xff) != 0; i++){
+    if(c != '%'){
+      pputc(b, c);
+      continue;
+    }
+    c = fmt[++i] & 0xff;
+    if(c == 0)
+      break;
+    switch(c){
+    case 'd':
+      pprintint(b, *argp++, 10, 1);
+      break;
+    case 'x':
+    case 'p':
+      pprintint(b, *argp++, 16, 0);
+      break;
+    case 's':
+      if((s = (char*)*argp++) == 0)
+        s = "(null)";
+      for(; *s; s++)
+        pputc(b, *s);
+      break;
+    default:
+      pputc(b, '%');
+      pputc(b, c);
+      break;
+    }
+  }
+}
+
+static char *queues[] = { [RR] "RR", [SJF] "SJF", [FCFS] "FCFS" };
+static char *states[] = {
+  [UNUSED]    "unused",
+  [EMBRYO]    "embryo",
+  [SLEEPING]  "sleeping",
+  [RUNNABLE]  "runnable",
+  [RUNNING]   "running",
+  [ZOMBIE]    "zombie"
+};
+
+//PAGEBREAK!
+// Global files.
+
+static void
+gsched(struct pbuf *b)
+{
+  struct cpu *c;
+
+  pprintf(b, "ticks %d\n", ticks);
+  for(c = cpus; c < cpus + ncpu; c++)
+    pprintf(b, "cpu%d queue %s queueticks %d ticks %d idle %d switches %d%s\n",
+            c - cpus, queues[c->schedqueue], c->queueticks, c->nticks,
+            c->idleticks, c->nswitch, c->idle ? " halted" : "");
+}
+
+static void
+gsyscalls(struct pbuf *b)
+{
+  struct cpu *c;
+
+  pprintf(b, "total %d\n", total_syscall);
+  for(c = cpus; c < cpus + ncpu; c++)
+    pprintf(b, "cpu%d %d\n", c - cpus, c->syscallnum);
+}
+
+static void
+glocks(struct pbuf *b)
+{
+  struct lockstat ls[NLOCKSTAT];
+  int i, n;
+
+  n = lockstats(ls, NLOCKSTAT);
+  pprintf(b, "lock contended spins\n");
+  for(i = 0; i < n; i++)
+    pprintf(b, "%s %d %d\n", ls[i].name, ls[i].contended, ls[i].spins);
+}
+
+static void
+gmem(struct pbuf *b)
+{
+  uint nfree, total;
+
+  nfree = kfreepages(&total);
+  pprintf(b, "pages %d free %d\n", total, nfree);
+  pprintf(b, "kb %d free %d\n", total * (PGSIZE/1024), nfree * (PGSIZE/1024));
+}
+
+static void
+gprocs(struct pbuf *b)
+{
+  struct procinfo *pi;
+  int slot, n, i;
+
+  if((pi = (struct procinfo*)kalloc()) == 0)
+    return;
+  pprintf(b, "pid ppid state queue sz name\n");
+  for(slot = 0; (n = snapprocs(pi, PGSIZE / sizeof(*pi), &slot)) > 0;)
+    for(i = 0; i < n; i++)
+      pprintf(b, "%d %d %s %s %d %s\n", pi[i].pid, pi[i].ppid,
+              states[pi[i].state], queues[pi[i].queue], pi[i].sz, pi[i].name);
+  kfree((char*)pi);
+}
+
+//PAGEBREAK!
+// Per-process files.  Each is generated with ptable.lock held
+// (see lockproc), so it only formats what is already there.
+
+static void
+psched(struct pbuf *b, struct proc *p)
+{
+  pprintf(b, "name %s\nstate %s\nqueue %s\n", p->name, states[p->state],
+          queues[p->schedqueue]);
+  pprintf(b, "wait %d\nconsecutive %d\narrival %d\nburst %d\nconfidence %d\n",
+          p->wait_time, p->consecutive_time, p->arraival, p->bursttime,
+          p->confidence);
+  pprintf(b, "utime_us %d\nstime_us %d\n", tscus(p->utime), tscus(p->stime));
+  pprintf(b, "wait_us RR %d SJF %d FCFS %d\n", tscus(p->qwait[RR]),
+          tscus(p->qwait[SJF]), tscus(p->qwait[FCFS]));
+}
+
+static void
+psyscalls(struct pbuf *b, struct proc *p)
+{
+  struct sysstat *st;
+  uint mean;
+  int i;
+
+  pprintf(b, "syscall calls mean_cycles\n");
+  for(i = 0; i < MAX_SYSCALLS; i++){
+    st = &p->sysstat[i];
+    if(st->count == 0)
+      continue;
+    mean = 0x7FFFFFFF;
+    if((st->cycles >> 31) < st->count)
+      mean = divq(st->cycles, st->count, 0);
+    pprintf(b, "%s %d %d\n", syscallname(i), st->count, mean);
+  }
+}
+
+static void
+pmem(struct pbuf *b, struct proc *p)
+{
+  struct vma *v;
+
+  pprintf(b, "sz %d\n", p->sz);
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len)
+      pprintf(b, "mmap 0x%x %d prot %d flags %d%s\n", v->addr, v->len,
+              v->prot, v->flags, v->f ? " file" : (v->shm ? " shm" : ""));
+}
+
+static struct {
+  char *name;
+  void (*global)(struct pbuf*);               // in /proc, or 0
+  void (*perproc)(struct pbuf*, struct proc*); // in /proc/pid, or 0
+} files[NPROCFILE] = {
+  [1] { "sched",    gsched,    psched },
+  [2] { "syscalls", gsyscalls, psyscalls },
+  [3] { "mem",      gmem,      pmem },
+  [4] { "locks",    glocks,    0 },
+  [5] { "procs",    gprocs,    0 },
+};
+
+//PAGEBREAK!
+// Return the in-memory inode for file f (0: the directory)
+// of process pid (0: the global files).
+static struct inode*
+procfsinode(int pid, int f)
+{
+  struct inode *ip;
+
+  ip = iget(PROCFSDEV, pid*NPROCFILE + f);
+  acquiresleep(&ip->lock);
+  if(!ip->valid){
+    ip->type = T_DEV;
+    ip->major = PROCFS;
+    ip->minor = 0;
+    ip->nlink = 1;  // never written back
+    ip->size = 0;
+    ip->valid = 1;
+  }
+  releasesleep(&ip->lock);
+  return ip;
+}
+
+// /proc itself is the on-disk node; the rest are on PROCFSDEV.
+static void
+procfsdecode(struct inode *ip, int *pid, int *f)
+{
+  if(ip->dev != PROCFSDEV){
+    *pid = 0;
+    *f = 0;
+  } else {
+    *pid = ip->inum / NPROCFILE;
+    *f = ip->inum % NPROCFILE;
+  }
+}
+
+static struct inode*
+procfslookup(struct inode *dp, char *name)
+{
+  int pid, f, n;
+  char *s;
+
+  procfsdecode(dp, &pid, &f);
+  if(f != 0)
+    return 0;  // not a directory
+  if(namecmp(name, ".") == 0)
+    return idup(dp);
+
+  for(f = 1; f < NPROCFILE; f++)
+    if(files[f].name && namecmp(name, files[f].name) == 0 &&
+       (pid ? files[f].perproc != 0 : files[f].global != 0))
+      return procfsinode(pid, f);
+
+  // In /proc, a pid names that process's directory.
+  if(pid != 0 || *name == 0)
+    return 0;
+  n = 0;
+  for(s = name; s < name + DIRSIZ && *s; s++){
+    if(*s < '0' || *s > '9')
+      return 0;
+    n = n*10 + *s - '0';
+  }
+  if(n <= 0 || lockproc(n) == 0)
+    return 0;
+  unlockproc();
+  return procfsinode(n, 0);
+}
+
+// Generate file f of process pid, or the listing of a directory.
+static void
+procfsgen(struct pbuf *b, int pid, int f)
+{
+  struct procinfo *pi;
+  struct proc *p;
+  int i, slot, n;
+
+  if(pid == 0 && f != 0){
+    files[f].global(b);
+    return;
+  }
+  if(pid != 0){
+    if((p = lockproc(pid)) == 0)
+      return;
+    for(i = 1; f == 0 && i < NPROCFILE; i++)
+      if(files[i].name && files[i].perproc)
+        pprintf(b, "%s\n", files[i].name);
+    if(f != 0)
+      files[f].perproc(b, p);
+    unlockproc();
+    return;
+  }
+
+  // The listing of /proc.
+  for(i = 1; i < NPROCFILE; i++)
+    if(files[i].name && files[i].global)
+      pprintf(b, "%s\n", files[i].name);
+  if((pi = (struct procinfo*)kalloc()) == 0)
+    return;
+  for(slot = 0; (n = snapprocs(pi, PGSIZE / sizeof(*pi), &slot)) > 0;)
+    for(i = 0; i < n; i++)
+      pprintf(b, "%d\n", pi[i].pid);
+  kfree((char*)pi);
+}
+
+static int
+procfsread(struct inode *ip, char *dst, int n, uint off)
+{
+  struct pbuf b;
+  int pid, f;
+
+  if((b.buf = kalloc()) == 0)
+    return -1;
+  b.n = 0;
+  procfsdecode(ip, &pid, &f);
+  procfsgen(&b, pid, f);
+  if(off >= b.n)
+    n = 0;
+  else if(n > b.n - off)
+    n = b.n - off;
+  memmove(dst, b.buf + off, n);
+  kfree(b.buf);
+  return n;
+}
+
+void
+procfsinit(void)
+{
+  devsw[PROCFS].read = procfsread;
+  devsw[PROCFS].lookup = procfslookup;
+}
@@ -0,0 +1,19 @@
+// A snapshot of one process, as returned by getprocs().
+
+struct procinfo {
+  int pid;
+  int ppid;
+  int state;        // 1 embryo, 2 sleeping, 3 runnable, 4 running, 5 zombie
+  int queue;        // 0 RR, 1 SJF, 2 FCFS
+  uint sz;          // bytes of memory, not counting mmap() regions
+  uint syscalls;    // system calls made
+  uint utime;       // microseconds run in user space
+  uint stime;       // microseconds run in the kernel
+  uint wait[3];     // microseconds runnable, by queue
+  int wait_time;    // scheduler state, in ticks
+  int consecutive;
+  int arrival;
+  int bursttime;
+  int confidence;
+  char name[16];
+};
@@ -0,0 +1,102 @@
+// Sampling profiler.
+//
+// While profiling, each CPU's timer interrupt records where
+// the CPU was (see trap.c) in that CPU's own buffer, and
+// armtimer() keeps every CPU ticking once per tick.  Samples
+// that do not fit are counted and dropped.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "proc.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "prof.h"
+
+struct profbuf {
+  uint n;        // samples taken
+  uint dropped;  // samples that did not fit
+  struct sample s[NPROFSAMPLE];
+};
+
+static struct profbuf profbuf[NCPU];
+static struct spinlock proflock;  // serializes profile()
+int profiling;                    // take samples only if set
+
+void
+profinit(void)
+{
+  initlock(&proflock, "prof");
+}
+
+// Record a sample for the timer interrupt that saved tf.
+// Interrupts must be off.
+void
+profsample(struct trapframe *tf)
+{
+  struct profbuf *pb = &profbuf[cpuid()];
+  struct proc *p = myproc();
+  struct sample *s;
+
+  if(pb->n >= NPROFSAMPLE){
+    pb->dropped++;
+    return;
+  }
+  s = &pb->s[pb->n++];
+  s->eip = tf->eip;
+  s->pid = p ? p->pid : 0;
+  s->cpu = cpuid();
+  s->user = (tf->cs & 3) == DPL_USER;
+  safestrcpy(s->name, p ? p->name : "", sizeof(s->name));
+}
+
+// Start, stop or dump the profile (see prof.h).  For a dump,
+// buf holds room for n samples and has been checked and
+// faulted in for writing; returns the number copied, and
+// reports any dropped samples on the console.
+int
+profile(int cmd, struct sample *buf, int n)
+{
+  struct profbuf *pb;
+  uint dropped;
+  int got;
+
+  acquire(&proflock);
+  switch(cmd){
+  case PROF_START:
+    profiling = 0;
+    for(pb = profbuf; pb < &profbuf[ncpu]; pb++)
+      pb->n = pb->dropped = 0;
+    profiling = 1;
+    got = 0;
+    break;
+  case PROF_STOP:
+    profiling = 0;
+    got = 0;
+    break;
+  case PROF_DUMP:
+    got = -1;
+    if(profiling)
+      break;
+    got = dropped = 0;
+    for(pb = profbuf; pb < &profbuf[ncpu]; pb++){
+      dropped += pb->dropped;
+      if(pb->n > (uint)(n - got)){
+        dropped += pb->n - (n - got);
+        memmove(buf + got, pb->s, (n - got) * sizeof(*buf));
+        got = n;
+      } else {
+        memmove(buf + got, pb->s, pb->n * sizeof(*buf));
+        got += pb->n;
+      }
+    }
+    if(dropped)
+      cprintf("profile: %d samples dropped\n", dropped);
+    break;
+  default:
+    got = -1;
+  }
+  release(&proflock);
+  return got;
+}
@@ -0,0 +1,13 @@
+// Profiler samples, as returned by profile(PROF_DUMP, ...).
+
+#define PROF_START 1  // drop old samples and start sampling
+#define PROF_STOP  2  // stop sampling
+#define PROF_DUMP  3  // copy out the samples taken; must be stopped
+
+struct sample {
+  uint eip;       // where the CPU was at a timer tick
+  ushort pid;     // whose it was; 0 if the CPU had no process
+  uchar cpu;
+  uchar user;     // eip is a user address
+  char name[16];  // the process's name
+};
@@ -0,0 +1,28 @@
+// Submission and completion ring for ring_enter().  The
+// process queues system calls at sq[sqtail % NRING] and bumps
+// sqtail; ring_enter() runs them in order from sqhead and
+// posts a result for each at cq[cqtail % NRING].  The process
+// consumes results from cqhead.  The ring lives in ordinary
+// user memory; the kernel touches it only inside ring_enter().
+
+#define NRING 32  // entries in each queue
+
+struct sqe {
+  uint data;    // copied to the completion
+  int num;      // SYS_read, SYS_write, SYS_open or SYS_close
+  int arg[3];   // the arguments, as the system call takes them
+};
+
+struct cqe {
+  uint data;    // from the submission
+  int res;      // what the system call returned
+};
+
+struct ring {
+  uint sqhead;  // next submission to run; kernel advances
+  uint sqtail;  // next free submission; process advances
+  uint cqhead;  // next result to read; process advances
+  uint cqtail;  // next free result; kernel advances
+  struct sqe sq[NRING];
+  struct cqe cq[NRING];
+};
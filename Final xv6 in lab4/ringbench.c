@@ -0,0 +1,119 @@
+// Write a file a block at a time with one write() per block,
+// then again with the writes batched through ring_enter(),
+// and read it back through the ring to check it.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "x86.h"
+#include "syscall.h"
+#include "ring.h"
+
+#define N 256  // blocks
+#define BSIZE 512
+
+static struct ring r;
+static char data[BSIZE], buf[NRING][BSIZE];
+
+// Queue system call num with arguments a0..a2 as request data.
+static void
+submit(uint data, int num, int a0, int a1, int a2)
+{
+  struct sqe *sqe = &r.sq[r.sqtail % NRING];
+
+  sqe->data = data;
+  sqe->num = num;
+  sqe->arg[0] = a0;
+  sqe->arg[1] = a1;
+  sqe->arg[2] = a2;
+  r.sqtail++;
+}
+
+// Submit everything queued and collect the results, checking
+// each against want.  Returns the number of failures.
+static int
+drain(int want)
+{
+  struct cqe *cqe;
+  int bad;
+
+  bad = 0;
+  while(r.sqhead != r.sqtail){
+    if(ring_enter(&r) < 0){
+      printf(1, "ringbench: ring_enter failed\n");
+      exit();
+    }
+    for(; r.cqhead != r.cqtail; r.cqhead++){
+      cqe = &r.cq[r.cqhead % NRING];
+      if(cqe->res != want){
+        printf(1, "ringbench: request %d returned %d\n", cqe->data, cqe->res);
+        bad++;
+      }
+    }
+  }
+  return bad;
+}
+
+int
+main(void)
+{
+  uint64 start;
+  uint us;
+  int fd, i, j, bad;
+
+  memset(data, 'r', sizeof(data));
+
+  fd = open("ringfile", O_CREATE | O_RDWR);
+  start = nsec();
+  for(i = 0; i < N; i++)
+    if(write(fd, data, BSIZE) != BSIZE){
+      printf(1, "ringbench: write failed\n");
+      exit();
+    }
+  us = usecsince(start);
+  close(fd);
+  printf(1, "write: %d blocks in %d us\n", N, us);
+  unlink("ringfile");
+
+  fd = open("ringfile", O_CREATE | O_RDWR);
+  start = nsec();
+  bad = 0;
+  for(i = 0; i < N; i++){
+    submit(i, SYS_write, fd, (int)data, BSIZE);
+    if(r.sqtail - r.sqhead == NRING)
+      bad += drain(BSIZE);
+  }
+  bad += drain(BSIZE);
+  us = usecsince(start);
+  close(fd);
+  printf(1, "ring write: %d blocks in %d us, %d traps\n", N, us, N / NRING);
+
+  // Read it back a ring at a time, then close it through the ring.
+  fd = open("ringfile", O_RDONLY);
+  for(i = 0; i < N; i += NRING){
+    for(j = 0; j < NRING; j++){
+      memset(buf[j], 0, BSIZE);
+      submit(i + j, SYS_read, fd, (int)buf[j], BSIZE);
+    }
+    bad += drain(BSIZE);
+    for(j = 0; j < NRING * BSIZE; j++)
+      if(buf[j / BSIZE][j % BSIZE] != data[j % BSIZE]){
+        printf(1, "ringbench: block %d differs\n", i + j / BSIZE);
+        bad++;
+        break;
+      }
+  }
+  submit(N, SYS_close, fd, 0, 0);
+  bad += drain(0);
+  if(read(fd, buf[0], 1) >= 0){
+    printf(1, "ringbench: close through the ring did not close\n");
+    bad++;
+  }
+  submit(N + 1, SYS_getpid, 0, 0, 0);
+  bad += drain(-1);  // not allowed in a ring
+  unlink("ringfile");
+
+  printf(1, "ringbench: %s\n", bad ? "FAILED" : "ok");
+  exit();
+}
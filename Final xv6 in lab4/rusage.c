@@ -0,0 +1,37 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "rusage.h"
+
+static void
+print(int pid)
+{
+  struct rusage ru;
+
+  if (getrusage(pid, &ru) < 0) {
+    printf(2, "Error: no process %d\n", pid);
+    return;
+  }
+  printf(1, "pid %d: user %d us, sys %d us, waited RR %d us, SJF %d us, FCFS %d us\n",
+         pid ? pid : getpid(), ru.utime, ru.stime, ru.wait[0], ru.wait[1], ru.wait[2]);
+}
+
+int main(int argc, char *argv[]) {
+  volatile int x;
+  int i;
+
+  // With no pids, report on some work of our own.
+  if (argc == 1) {
+    for (i = 0, x = 0; i < 10000000; i++)
+      x += i;
+    for (i = 0; i < 1000; i++)
+      getpid();
+    sleep(10);
+    print(0);
+    exit();
+  }
+
+  for (i = 1; i < argc; i++)
+    print(atoi(argv[i]));
+  exit();
+}
@@ -0,0 +1,8 @@
+// Per-process CPU accounting, as returned by getrusage().
+
+struct rusage {
+  uint utime;    // microseconds run in user space
+  uint stime;    // microseconds run in the kernel
+  uint wait[3];  // microseconds runnable but not running,
+                 // by queue: RR, SJF, FCFS
+};
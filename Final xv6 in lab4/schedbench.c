@@ -0,0 +1,292 @@
+// Run a mix of CPU-bound, I/O-bound and interactive tasks
+// spread over the scheduling queues, and report for each class
+// the mean turnaround and response time and the throughput.
+// Also report the Jain fairness index of the CPU shares the
+// CPU-bound tasks got, and context switches per second.
+//
+// usage: schedbench [cpu io interactive [queue]]
+//
+// By default task i goes to queue i % 3 (RR, SJF, FCFS); a
+// queue argument puts every task there.  Interactive tasks
+// wait on a pipe that a driver writes a timestamp to every
+// tick; their wake latency is how long that took to arrive.
+//
+// Results go to stdout as key=value lines, one per class
+// starting "class=" and a summary starting "total".
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "x86.h"
+#include "rusage.h"
+
+#define NTASK  16
+#define KEY    0x73636862  // "schb"
+#define CPUFIB 32          // each CPU-bound task computes fib(CPUFIB)
+#define NIO    8           // rounds of file writes and reads
+#define IOSIZE (16*1024)
+#define NWAKE  50          // wakeups per interactive task
+
+enum { CPU, IO, INTERACTIVE, NCLASS };
+char *classes[] = { "cpu", "io", "interactive" };
+int bursts[] = { 8, 3, 1 };  // set_bc() estimates for SJF
+
+// One task's measurements, in the shared segment.
+struct result {
+  int class;
+  int queue;
+  uint64 forked;    // nsec() just before fork()
+  uint64 started;   // when the child first ran
+  uint64 done;      // when it finished its work
+  uint utime, stime;
+  uint64 wakelat;   // interactive: total wake latency, ns
+  uint maxlat;      // and the worst, ns
+};
+
+struct result *res;
+char iobuf[512];
+
+int
+fib(int n)
+{
+  if(n <= 1)
+    return n;
+  return fib(n - 1) + fib(n - 2);
+}
+
+void
+iotask(int i)
+{
+  char name[8];
+  int fd, r, n;
+
+  name[0] = 's';
+  name[1] = 'b';
+  name[2] = '0' + i / 10;
+  name[3] = '0' + i % 10;
+  name[4] = 0;
+  memset(iobuf, i, sizeof(iobuf));
+  for(r = 0; r < NIO; r++){
+    if((fd = open(name, O_CREATE | O_RDWR)) < 0)
+      fail("schedbench", "open");
+    for(n = 0; n < IOSIZE; n += sizeof(iobuf))
+      if(write(fd, iobuf, sizeof(iobuf)) != sizeof(iobuf))
+        fail("schedbench", "write");
+    close(fd);
+    if((fd = open(name, O_RDONLY)) < 0)
+      fail("schedbench", "open");
+    while(read(fd, iobuf, sizeof(iobuf)) > 0)
+      ;
+    close(fd);
+  }
+  unlink(name);
+}
+
+void
+interactivetask(struct result *r, int fd)
+{
+  uint64 stamp;
+  uint lat;
+  int n;
+
+  for(n = 0; n < NWAKE; n++){
+    if(read(fd, &stamp, sizeof(stamp)) != sizeof(stamp))
+      fail("schedbench", "read");
+    lat = nsec() - stamp;
+    r->wakelat += lat;
+    if(lat > r->maxlat)
+      r->maxlat = lat;
+    fib(15);  // a short burst of work per wakeup
+  }
+}
+
+// Context switches so far, summed over CPUs from /proc/sched.
+uint
+switches(void)
+{
+  static char buf[1024];
+  char *s;
+  uint sum;
+  int fd, n;
+
+  if((fd = open("/proc/sched", O_RDONLY)) < 0)
+    return 0;
+  n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if(n < 0)
+    n = 0;
+  buf[n] = 0;
+  sum = 0;
+  for(s = buf; (s = strchr(s, 's')) != 0; s++)
+    if(s[1] == 'w' && s[2] == 'i' && s[3] == 't' && s[8] == ' ')
+      sum += atoi(s + 9);  // "switches N"
+  return sum;
+}
+
+// Jain's index (sum x)^2 / (n * sum x^2) of the CPU shares,
+// in thousandths.
+uint
+fairness(void)
+{
+  uint64 sum, sumsq;
+  uint x, n, turn;
+  int i;
+
+  sum = sumsq = n = 0;
+  for(i = 0; i < NTASK; i++){
+    if(res[i].class != CPU || res[i].done == 0)
+      continue;
+    turn = divq(res[i].done - res[i].forked, 1000, 0);
+    x = turn ? divq((uint64)res[i].utime * 1000, turn, 0) : 0;
+    sum += x;
+    sumsq += (uint64)x * x;
+    n++;
+  }
+  return jain(sum, sumsq, n);
+}
+
+void
+report(int class)
+{
+  uint64 turn, resp, lat, nwake, first, last;
+  uint maxlat, n, span;
+  int i;
+
+  turn = resp = lat = nwake = first = last = maxlat = n = 0;
+  for(i = 0; i < NTASK; i++){
+    if(res[i].class != class || res[i].done == 0)
+      continue;
+    turn += res[i].done - res[i].forked;
+    resp += res[i].started - res[i].forked;
+    if(first == 0 || res[i].forked < first)
+      first = res[i].forked;
+    if(res[i].done > last)
+      last = res[i].done;
+    lat += res[i].wakelat;
+    nwake += NWAKE;
+    if(res[i].maxlat > maxlat)
+      maxlat = res[i].maxlat;
+    n++;
+  }
+  if(n == 0)
+    return;
+  span = divq(last - first, 1000, 0);
+  printf(1, "class=%s n=%d turnaround_us=%d response_us=%d throughput=",
+         classes[class], n, divq(turn, n * 1000, 0), divq(resp, n * 1000, 0));
+  fixed(span ? divq((uint64)n * 1000000000, span, 0) : 0);
+  if(class == CPU){
+    printf(1, " fairness=");
+    fixed(fairness());
+  }
+  if(class == INTERACTIVE)
+    printf(1, " wake_us=%d max_wake_us=%d", divq(lat, nwake * 1000, 0),
+           maxlat / 1000);
+  printf(1, "\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  int count[NCLASS] = { 4, 2, 2 };
+  int wake[2], queue, ntask, i, c, pid;
+  uint64 start, end;
+  uint sw, us;
+  struct rusage ru;
+  int id;
+
+  queue = -1;
+  for(c = 0; c < NCLASS && c + 1 < argc; c++)
+    count[c] = atoi(argv[c + 1]);
+  if(argc > 4)
+    queue = atoi(argv[4]);
+  ntask = count[CPU] + count[IO] + count[INTERACTIVE];
+  if(ntask > NTASK || queue > 2){
+    printf(2, "usage: schedbench [cpu io interactive [queue]], at most %d tasks\n",
+           NTASK);
+    exit();
+  }
+
+  if((id = shm_open(KEY, NTASK * sizeof(struct result))) < 0)
+    fail("schedbench", "shm_open");
+  if((res = shm_attach(id)) == (struct result*)-1)
+    fail("schedbench", "shm_attach");
+  memset(res, 0, NTASK * sizeof(struct result));
+  if(pipe(wake) < 0)
+    fail("schedbench", "pipe");
+
+  printf(1, "schedbench cpu=%d io=%d interactive=%d queue=%s\n",
+         count[CPU], count[IO], count[INTERACTIVE],
+         queue < 0 ? "spread" : queue == 0 ? "RR" : queue == 1 ? "SJF" : "FCFS");
+  sw = switches();
+  start = nsec();
+  i = 0;
+  for(c = 0; c < NCLASS; c++){
+    for(; count[c] > 0; count[c]--, i++){
+      res[i].class = c;
+      res[i].queue = queue < 0 ? i % 3 : queue;
+      res[i].forked = nsec();
+      if((pid = fork()) < 0)
+        fail("schedbench", "fork");
+      if(pid == 0){
+        res[i].started = nsec();
+        close(wake[1]);
+        if(c == CPU)
+          fib(CPUFIB);
+        else if(c == IO)
+          iotask(i);
+        else
+          interactivetask(&res[i], wake[0]);
+        res[i].done = nsec();
+        if(getrusage(getpid(), &ru) == 0){
+          res[i].utime = ru.utime;
+          res[i].stime = ru.stime;
+        }
+        exit();
+      }
+      if(res[i].queue == 1)
+        set_bc(pid, bursts[c], 50);
+      change_queue(pid, res[i].queue);
+    }
+  }
+
+  // The driver stamps one message per interactive task a tick.
+  ntask = i;
+  for(c = 0, i = 0; i < ntask; i++)
+    if(res[i].class == INTERACTIVE)
+      c++;
+  if(c > 0 && fork() == 0){
+    uint64 stamp;
+    int n, k;
+
+    close(wake[0]);
+    for(n = 0; n < NWAKE; n++){
+      sleep(1);
+      for(k = 0; k < c; k++){
+        stamp = nsec();
+        write(wake[1], &stamp, sizeof(stamp));
+      }
+    }
+    exit();
+  }
+  close(wake[0]);
+  close(wake[1]);
+
+  while(wait() >= 0)
+    ;
+  end = nsec();
+  sw = switches() - sw;
+  us = divq(end - start, 1000, 0);
+
+  for(c = 0; c < NCLASS; c++)
+    report(c);
+  printf(1, "total n=%d elapsed_us=%d throughput=", ntask, us);
+  fixed(us ? divq((uint64)ntask * 1000000000, us, 0) : 0);
+  printf(1, " fairness=");
+  fixed(fairness());
+  printf(1, " switches=%d switches_per_s=%d\n", sw,
+         us ? divq((uint64)sw * 1000000, us, 0) : 0);
+
+  shm_detach(res);
+  exit();
+}
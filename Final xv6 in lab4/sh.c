@@ -52,12 +52,17 @@ struct backcmd {
 int fork1(void);  // Fork but panics on failure.
 void panic(char*);
 struct cmd *parsecmd(char*);
+int spawncmd(struct cmd*, int*);
+int simpleline(char*);
+void freecmd(struct cmd*);
+
+int usespawn = 1;  // run simple commands with spawn() instead of fork()+exec()
 
 // Execute cmd.  Never returns.
 void
 runcmd(struct cmd *cmd)
 {
-  int p[2];
+  int p[2], fds[3];
   struct backcmd *bcmd;
   struct execcmd *ecmd;
   struct listcmd *lcmd;
@@ -91,7 +96,7 @@ runcmd(struct cmd *cmd)
 
   case LIST:
     lcmd = (struct listcmd*)cmd;
-    if(fork1() == 0)
+    if(spawncmd(lcmd->left, 0) < 0 && fork1() == 0)
       runcmd(lcmd->left);
     wait();
     runcmd(lcmd->right);
@@ -101,14 +106,19 @@ runcmd(struct cmd *cmd)
     pcmd = (struct pipecmd*)cmd;
     if(pipe(p) < 0)
       panic("pipe");
-    if(fork1() == 0){
+    fds[0] = 0;
+    fds[1] = p[1];
+    fds[2] = 2;
+    if(spawncmd(pcmd->left, fds) < 0 && fork1() == 0){
       close(1);
       dup(p[1]);
       close(p[0]);
       close(p[1]);
       runcmd(pcmd->left);
     }
-    if(fork1() == 0){
+    fds[0] = p[0];
+    fds[1] = 1;
+    if(spawncmd(pcmd->right, fds) < 0 && fork1() == 0){
       close(0);
       dup(p[0]);
       close(p[0]);
@@ -130,6 +140,69 @@ runcmd(struct cmd *cmd)
   exit();
 }
 
+// Start a simple command (an exec, possibly under redirections)
+// with spawn(), so the shell skips copying its own address space.
+// fds gives the child's stdin, stdout and stderr (0 means the
+// shell's own).  Returns the child's pid, 0 if the command failed
+// to start, or -1 if cmd is not simple and must go through runcmd.
+int
+spawncmd(struct cmd *cmd, int *fds)
+{
+  int i, pid, fdmap[3], opened[3];
+  struct execcmd *ecmd;
+  struct redircmd *rcmd;
+  struct cmd *c;
+
+  if(!usespawn || cmd == 0)
+    return -1;
+  for(c = cmd; c->type == REDIR; c = ((struct redircmd*)c)->cmd)
+    if(((struct redircmd*)c)->fd > 2)
+      return -1;
+  if(c->type != EXEC)
+    return -1;
+  ecmd = (struct execcmd*)c;
+  if(ecmd->argv[0] == 0)
+    return 0;
+
+  for(i = 0; i < 3; i++){
+    fdmap[i] = fds ? fds[i] : i;
+    opened[i] = -1;
+  }
+  // Outer redirections are applied first, so inner ones win,
+  // just as in runcmd.
+  for(c = cmd; c->type == REDIR; c = rcmd->cmd){
+    rcmd = (struct redircmd*)c;
+    if(opened[rcmd->fd] >= 0)
+      close(opened[rcmd->fd]);
+    if((opened[rcmd->fd] = open(rcmd->file, rcmd->mode)) < 0){
+      printf(2, "open %s failed\n", rcmd->file);
+      pid = 0;
+      goto out;
+    }
+    fdmap[rcmd->fd] = opened[rcmd->fd];
+  }
+
+  if((pid = spawn(ecmd->argv[0], ecmd->argv, fdmap)) < 0){
+    printf(2, "exec %s failed\n", ecmd->argv[0]);
+    pid = 0;
+  }
+
+out:
+  for(i = 0; i < 3; i++)
+    if(opened[i] >= 0)
+      close(opened[i]);
+  return pid;
+}
+
+// Free a command tree built from a simple line.
+void
+freecmd(struct cmd *cmd)
+{
+  if(cmd->type == REDIR)
+    freecmd(((struct redircmd*)cmd)->cmd);
+  free(cmd);
+}
+
 int
 getcmd(char *buf, int nbuf)
 {
@@ -142,11 +215,16 @@ getcmd(char *buf, int nbuf)
 }
 
 int
-main(void)
+main(int argc, char *argv[])
 {
   static char buf[100];
+  struct cmd *cmd;
   int fd;
 
+  // sh -f: always fork, e.g. to compare against the spawn path.
+  if(argc > 1 && strcmp(argv[1], "-f") == 0)
+    usespawn = 0;
+
   // Ensure that three file descriptors are open.
   while((fd = open("console", O_RDWR)) >= 0){
     if(fd >= 3){
@@ -164,7 +242,13 @@ main(void)
         printf(2, "cannot cd %s\n", buf+3);
       continue;
     }
-    if(fork1() == 0)
+    if(usespawn && simpleline(buf)){
+      // Parsing in the shell itself is safe: simpleline() has
+      // ruled out everything parsecmd would panic on.
+      cmd = parsecmd(buf);
+      spawncmd(cmd, 0);
+      freecmd(cmd);
+    } else if(fork1() == 0)
       runcmd(parsecmd(buf));
     wait();
   }
@@ -319,6 +403,29 @@ peek(char **ps, char *es, char *toks)
   return *s && strchr(toks, *s);
 }
 
+// Report whether buf is a single command whose only operators
+// are < and > redirections, each followed by a file name.
+int
+simpleline(char *buf)
+{
+  char *s, *es;
+  int tok, nargs;
+
+  s = buf;
+  es = s + strlen(s);
+  nargs = 0;
+  while((tok = gettoken(&s, es, 0, 0)) != 0){
+    if(tok == 'a')
+      nargs++;
+    else if(tok == '<' || tok == '>' || tok == '+'){
+      if(gettoken(&s, es, 0, 0) != 'a')
+        return 0;
+    } else
+      return 0;
+  }
+  return nargs > 0 && nargs < MAXARGS;
+}
+
 struct cmd *parseline(char**, char*);
 struct cmd *parsepipe(char**, char*);
 struct cmd *parseexec(char**, char*);
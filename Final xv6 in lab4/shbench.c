@@ -0,0 +1,77 @@
+// Commands per second for a scripted shell workload, once with
+// the shell's spawn() fast path and once with fork()+exec().
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NCMD 100
+
+char *script = "shbench.sh";
+char *line = "echo shbench > shbench.out\n";
+
+int
+run(char *mode)
+{
+  char *argv[3];
+  int pid, start;
+
+  argv[0] = "sh";
+  argv[1] = mode;
+  argv[2] = 0;
+
+  start = uptime();
+  pid = fork();
+  if(pid < 0){
+    printf(1, "shbench: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    close(0);
+    if(open(script, O_RDONLY) < 0){
+      printf(1, "shbench: cannot open %s\n", script);
+      exit();
+    }
+    // Keep the prompts off the console.
+    close(2);
+    open("shbench.err", O_CREATE | O_RDWR);
+    exec("sh", argv);
+    printf(1, "shbench: exec sh failed\n");
+    exit();
+  }
+  wait();
+  return uptime() - start;
+}
+
+void
+report(char *name, int t)
+{
+  if(t == 0)
+    t = 1;
+  printf(1, "%s: %d commands in %d ticks, %d commands/sec\n",
+         name, NCMD, t, NCMD * 100 / t);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i;
+
+  unlink(script);
+  if((fd = open(script, O_CREATE | O_WRONLY)) < 0){
+    printf(1, "shbench: cannot create %s\n", script);
+    exit();
+  }
+  for(i = 0; i < NCMD; i++)
+    write(fd, line, strlen(line));
+  close(fd);
+
+  report("spawn", run(0));
+  report("fork+exec", run("-f"));
+
+  unlink(script);
+  unlink("shbench.out");
+  unlink("shbench.err");
+  exit();
+}
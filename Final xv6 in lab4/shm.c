@@ -0,0 +1,244 @@
+// Shared-memory segments and futexes.
+//
+// A segment is a set of zeroed pages named by a key.  Processes
+// that attach it get an mmap() region whose pages are the
+// segment's own, so writes are seen by everyone at once.  The
+// table holds one reference to each page; mappings hold their
+// own, taken when a page is faulted in (see vmafault).
+//
+// A futex is any aligned int in user memory, named by its
+// physical address so that processes sharing the page agree.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+
+struct {
+  struct spinlock lock;
+  struct {
+    int key;      // 0 if the slot is free
+    int npages;
+    int nopen;    // processes that have it open
+    int nattach;  // mmap() regions referring to it
+    char *pages[NSHMPG];
+  } seg[NSHM];
+} shmtable;
+
+struct spinlock futexlock;
+
+void
+shminit(void)
+{
+  initlock(&shmtable.lock, "shm");
+  initlock(&futexlock, "futex");
+}
+
+// Free segment id if no process has it open and no region is
+// attached to it.  Caller holds shmtable.lock.
+static void
+shmfree(int id)
+{
+  int i;
+
+  if(shmtable.seg[id].nopen > 0 || shmtable.seg[id].nattach > 0)
+    return;
+  for(i = 0; i < shmtable.seg[id].npages; i++)
+    kfree(shmtable.seg[id].pages[i]);
+  shmtable.seg[id].key = 0;
+  shmtable.seg[id].npages = 0;
+}
+
+// The current process has segment id open.  Caller holds
+// shmtable.lock.
+static void
+shmhold(int id)
+{
+  struct proc *p = myproc();
+
+  if(!(p->shmheld & (1 << id))){
+    p->shmheld |= 1 << id;
+    shmtable.seg[id].nopen++;
+  }
+}
+
+// Return the id of the segment named key, creating it with
+// size bytes if there is none yet.  A segment lives while some
+// process has it open (until that process exits) or some region
+// is attached to it.
+int
+shmopen(int key, uint size)
+{
+  int i, id, n;
+
+  n = PGROUNDUP(size) / PGSIZE;
+  if(key == 0 || n == 0 || n > NSHMPG)
+    return -1;
+
+  acquire(&shmtable.lock);
+  id = -1;
+  for(i = 0; i < NSHM; i++){
+    if(shmtable.seg[i].key == key){
+      if(shmtable.seg[i].npages < n)
+        i = -1;
+      else
+        shmhold(i);
+      release(&shmtable.lock);
+      return i;
+    }
+    if(shmtable.seg[i].key == 0 && id < 0)
+      id = i;
+  }
+  if(id < 0){
+    release(&shmtable.lock);
+    return -1;
+  }
+  for(i = 0; i < n; i++){
+    if((shmtable.seg[id].pages[i] = kalloc()) == 0){
+      while(--i >= 0)
+        kfree(shmtable.seg[id].pages[i]);
+      release(&shmtable.lock);
+      return -1;
+    }
+    memset(shmtable.seg[id].pages[i], 0, PGSIZE);
+  }
+  shmtable.seg[id].key = key;
+  shmtable.seg[id].npages = n;
+  shmtable.seg[id].nopen = 0;
+  shmtable.seg[id].nattach = 0;
+  shmhold(id);
+  release(&shmtable.lock);
+  return id;
+}
+
+// Bytes in segment id, or 0 if there is no such segment.
+uint
+shmsize(int id)
+{
+  uint n;
+
+  if(id < 0 || id >= NSHM)
+    return 0;
+  acquire(&shmtable.lock);
+  n = shmtable.seg[id].key ? shmtable.seg[id].npages * PGSIZE : 0;
+  release(&shmtable.lock);
+  return n;
+}
+
+// Page i of segment id, with a reference for the caller.
+char*
+shmpage(int id, int i)
+{
+  char *mem;
+
+  acquire(&shmtable.lock);
+  mem = 0;
+  if(shmtable.seg[id].key && i < shmtable.seg[id].npages){
+    mem = shmtable.seg[id].pages[i];
+    kref(mem);
+  }
+  release(&shmtable.lock);
+  return mem;
+}
+
+// Another region refers to segment id.
+void
+shmdup(int id)
+{
+  acquire(&shmtable.lock);
+  shmtable.seg[id].nattach++;
+  release(&shmtable.lock);
+}
+
+// A region referring to segment id went away.
+void
+shmclose(int id)
+{
+  acquire(&shmtable.lock);
+  shmtable.seg[id].nattach--;
+  shmfree(id);
+  release(&shmtable.lock);
+}
+
+// Child np has the segments the current process has open.
+void
+shmfork(struct proc *np)
+{
+  int i;
+
+  acquire(&shmtable.lock);
+  np->shmheld = myproc()->shmheld;
+  for(i = 0; i < NSHM; i++)
+    if(np->shmheld & (1 << i))
+      shmtable.seg[i].nopen++;
+  release(&shmtable.lock);
+}
+
+// The current process is exiting: close its segments.
+void
+shmexit(void)
+{
+  struct proc *p = myproc();
+  int i;
+
+  acquire(&shmtable.lock);
+  for(i = 0; i < NSHM; i++){
+    if(p->shmheld & (1 << i)){
+      shmtable.seg[i].nopen--;
+      shmfree(i);
+    }
+  }
+  p->shmheld = 0;
+  release(&shmtable.lock);
+}
+
+// Return the kernel address of the futex at user address addr.
+static int*
+futexaddr(uint addr)
+{
+  struct proc *p = myproc();
+  char *mem;
+
+  if(addr % 4 != 0 || uvmtouch(p, addr, 4, 0) < 0)
+    return 0;
+  if((mem = uva2ka(p->pgdir, (char*)addr)) == 0)
+    return 0;
+  return (int*)(mem + (addr % PGSIZE));
+}
+
+// Sleep until futexwake(addr), unless *addr is no longer val.
+// May also return early if the process is killed; callers
+// recheck their condition in a loop.
+int
+futexwait(uint addr, int val)
+{
+  int *k;
+
+  if((k = futexaddr(addr)) == 0)
+    return -1;
+  acquire(&futexlock);
+  if(*k != val){
+    release(&futexlock);
+    return -1;
+  }
+  sleep(k, &futexlock);
+  release(&futexlock);
+  return 0;
+}
+
+// Wake every process waiting on the futex at addr.
+int
+futexwake(uint addr)
+{
+  int *k;
+
+  if((k = futexaddr(addr)) == 0)
+    return -1;
+  acquire(&futexlock);
+  wakeup(k);
+  release(&futexlock);
+  return 0;
+}
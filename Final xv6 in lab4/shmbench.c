@@ -0,0 +1,137 @@
+// Move the same bytes from a parent to its child through a
+// pipe and through a shared-memory ring, and compare.
+// The ring is single-producer, single-consumer; each side
+// sleeps on a futex only when the ring is full or empty.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define TOTAL (4*1024*1024)
+#define KEY   0x73686d   // "shm"
+#define NPG   16         // segment pages: one header, the rest data
+#define CAP   ((NPG-1)*4096)
+#define CHUNK 4096
+
+struct ring {
+  volatile uint head;  // bytes produced
+  volatile uint tail;  // bytes consumed
+  volatile int pwait;  // producer is waiting for room
+  volatile int cwait;  // consumer is waiting for data
+};
+
+char src[CHUNK];
+char buf[512];
+
+uint
+expected(void)
+{
+  uint i, sum;
+
+  sum = 0;
+  for(i = 0; i < CHUNK; i++)
+    sum += (uchar)src[i];
+  return sum * (TOTAL / CHUNK);
+}
+
+int
+bypipe(void)
+{
+  int fds[2], n, i, start;
+  uint sum, off;
+
+  start = uptime();
+  if(pipe(fds) < 0)
+    fail("shmbench", "pipe");
+  if(fork() == 0){
+    close(fds[1]);
+    sum = 0;
+    while((n = read(fds[0], buf, sizeof(buf))) > 0)
+      for(i = 0; i < n; i++)
+        sum += (uchar)buf[i];
+    if(sum != expected())
+      fail("shmbench", "pipe data");
+    exit();
+  }
+  close(fds[0]);
+  for(off = 0; off < TOTAL; off += CHUNK)
+    if(write(fds[1], src, CHUNK) != CHUNK)
+      fail("shmbench", "pipe write");
+  close(fds[1]);
+  wait();
+  return uptime() - start;
+}
+
+int
+byshm(void)
+{
+  int id, start;
+  char *seg, *data;
+  struct ring *r;
+  uint off, h, t, i, sum;
+
+  start = uptime();
+  if((id = shm_open(KEY, NPG*4096)) < 0)
+    fail("shmbench", "shm_open");
+  if((seg = shm_attach(id)) == (char*)-1)
+    fail("shmbench", "shm_attach");
+  r = (struct ring*)seg;
+  data = seg + 4096;
+
+  if(fork() == 0){
+    // Consume in place: no copy out of the ring.
+    sum = 0;
+    for(off = 0; off < TOTAL; off += CHUNK){
+      while(r->head == r->tail){
+        r->cwait = 1;
+        __sync_synchronize();
+        h = r->head;
+        if(h == r->tail)
+          futex_wait((int*)&r->head, h);
+        r->cwait = 0;
+      }
+      for(i = 0; i < CHUNK; i++)
+        sum += (uchar)data[r->tail % CAP + i];
+      r->tail += CHUNK;
+      __sync_synchronize();
+      if(r->pwait)
+        futex_wake((int*)&r->tail);
+    }
+    if(sum != expected())
+      fail("shmbench", "shm data");
+    exit();
+  }
+
+  for(off = 0; off < TOTAL; off += CHUNK){
+    while(r->head - r->tail == CAP){
+      r->pwait = 1;
+      __sync_synchronize();
+      t = r->tail;
+      if(r->head - t == CAP)
+        futex_wait((int*)&r->tail, t);
+      r->pwait = 0;
+    }
+    memmove(data + r->head % CAP, src, CHUNK);
+    r->head += CHUNK;
+    __sync_synchronize();
+    if(r->cwait)
+      futex_wake((int*)&r->head);
+  }
+  wait();
+  if(shm_detach(seg) < 0)
+    fail("shmbench", "shm_detach");
+  return uptime() - start;
+}
+
+int
+main(void)
+{
+  int i, tp, ts;
+
+  for(i = 0; i < CHUNK; i++)
+    src[i] = i * 7;
+  tp = bypipe();
+  ts = byshm();
+  printf(1, "shmbench: %d bytes: pipe %d ticks, shm %d ticks\n", TOTAL, tp, ts);
+  exit();
+}
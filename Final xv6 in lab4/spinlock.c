@@ -8,6 +8,7 @@
 #include "mmu.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "trace.h"
 
 void
 initlock(struct spinlock *lk, char *name)
@@ -17,6 +18,56 @@ initlock(struct spinlock *lk, char *name)
   lk->cpu = 0;
 }
 
+// Contention counts by lock name, kept per CPU so that
+// acquire() can update them without a lock of their own.
+static struct lockstat lockstat[NCPU][NLOCKSTAT];
+
+// Count a contended acquire of a lock named name that spun
+// spins times.  Interrupts must be off.
+static void
+contended(char *name, uint spins)
+{
+  struct lockstat *ls, *end;
+
+  ls = lockstat[cpuid()];
+  for(end = ls + NLOCKSTAT; ls < end; ls++){
+    if(ls->name == 0)
+      ls->name = name;
+    if(ls->name == name){
+      ls->contended++;
+      ls->spins += spins;
+      return;
+    }
+  }
+}
+
+// Copy out up to max contention counts, summed over the
+// CPUs.  Returns the number of lock names.
+int
+lockstats(struct lockstat *out, int max)
+{
+  struct lockstat *ls;
+  int c, i, n;
+
+  n = 0;
+  for(c = 0; c < ncpu; c++){
+    for(ls = lockstat[c]; ls < &lockstat[c][NLOCKSTAT] && ls->name; ls++){
+      for(i = 0; i < n && out[i].name != ls->name; i++)
+        ;
+      if(i == n){
+        if(n == max)
+          continue;
+        out[n].name = ls->name;
+        out[n].contended = out[n].spins = 0;
+        n++;
+      }
+      out[i].contended += ls->contended;
+      out[i].spins += ls->spins;
+    }
+  }
+  return n;
+}
+
 // Acquire the lock.
 // Loops (spins) until the lock is acquired.
 // Holding a lock for a long time may cause
@@ -24,13 +75,16 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  uint spins;
+
   pushcli(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
 
   // The xchg is atomic.
+  spins = 0;
   while(xchg(&lk->locked, 1) != 0)
-    ;
+    spins++;
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
@@ -40,6 +94,11 @@ acquire(struct spinlock *lk)
   // Record info about lock acquisition for debugging.
   lk->cpu = mycpu();
   getcallerpcs(&lk, lk->pcs);
+  if(spins){
+    contended(lk->name, spins);
+    if(tracing)
+      trace(TR_LOCK, mycpu()->proc ? mycpu()->proc->pid : 0, spins, 0, lk->name);
+  }
 }
 
 // Release the lock.
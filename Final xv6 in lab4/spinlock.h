@@ -9,3 +9,10 @@ struct spinlock {
                      // that locked the lock.
 };
 
+// Contention on the locks with one name (see acquire).
+struct lockstat {
+  char *name;
+  uint contended;    // acquire() calls that had to spin
+  uint spins;        // times they spun
+};
+
@@ -0,0 +1,49 @@
+// Time a null system call, getpid(), entered by int $T_SYSCALL
+// as usys.S used to, and by sysenter as usys.S does now.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+#include "syscall.h"
+#include "traps.h"
+
+#define N 100000
+
+static int
+intgetpid(void)
+{
+  int pid;
+
+  asm volatile("int %1" : "=a" (pid) : "i" (T_SYSCALL), "a" (SYS_getpid)
+               : "memory");
+  return pid;
+}
+
+int
+main(void)
+{
+  uint64 start;
+  uint intus, sysus;
+  int i;
+
+  if(intgetpid() != getpid()){
+    printf(1, "sysbench: int getpid %d, sysenter getpid %d\n",
+           intgetpid(), getpid());
+    exit();
+  }
+
+  start = nsec();
+  for(i = 0; i < N; i++)
+    intgetpid();
+  intus = usecsince(start);
+
+  start = nsec();
+  for(i = 0; i < N; i++)
+    getpid();
+  sysus = usecsince(start);
+
+  printf(1, "getpid: %d ns by int, %d ns by sysenter\n",
+         divq((uint64)intus * 1000, N, 0), divq((uint64)sysus * 1000, N, 0));
+  exit();
+}
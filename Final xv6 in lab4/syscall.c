@@ -7,6 +7,7 @@
 #include "x86.h"
 #include "syscall.h"
 #include "spinlock.h"
+#include "trace.h"
 
 // User code makes a system call with INT T_SYSCALL.
 // System call number in %eax.
@@ -20,7 +21,9 @@ fetchint(uint addr, int *ip)
 {
   struct proc *curproc = myproc();
 
-  if(addr >= curproc->sz || addr+4 > curproc->sz)
+  if(addr+4 < addr || addr+4 > uvmlimit(curproc, addr))
+    return -1;
+  if(uvmtouch(curproc, addr, 4, 0) < 0)
     return -1;
   *ip = *(int*)(addr);
   return 0;
@@ -35,11 +38,14 @@ fetchstr(uint addr, char **pp)
   char *s, *ep;
   struct proc *curproc = myproc();
 
-  if(addr >= curproc->sz)
+  if((ep = (char*)uvmlimit(curproc, addr)) == 0)
     return -1;
   *pp = (char*)addr;
-  ep = (char*)curproc->sz;
   for(s = *pp; s < ep; s++){
+    // Heap pages may not be allocated yet.
+    if((s == *pp || (uint)s % PGSIZE == 0) &&
+       uvmtouch(curproc, (uint)s, 1, 0) < 0)
+      return -1;
     if(*s == 0)
       return s - *pp;
   }
@@ -64,7 +70,10 @@ argptr(int n, char **pp, int size)
  
   if(argint(n, &i) < 0)
     return -1;
-  if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
+  if(size < 0 || (uint)i+size < (uint)i ||
+     (uint)i+size > uvmlimit(curproc, i))
+    return -1;
+  if(uvmtouch(curproc, i, size, 0) < 0)
     return -1;
   *pp = (char*)i;
   return 0;
@@ -72,8 +81,9 @@ argptr(int n, char **pp, int size)
 
 // Fetch the nth word-sized system call argument as a string pointer.
 // Check that the pointer is valid and the string is nul-terminated.
-// (There is no shared writable memory, so the string can't change
-// between this check and being used by the kernel.)
+// The kernel then uses the string where it is.  If it is in memory
+// shared with another process (shm_attach(), MAP_SHARED), that
+// process can change it between this check and that use.
 int
 argstr(int n, char **pp)
 {
@@ -114,6 +124,25 @@ extern int sys_processes_info(void);
 extern int sys_set_bc(void);
 extern int sys_nsyscalls(void);
 extern int sys_reentrantlocktest(void);
+extern int sys_spawn(void);
+extern int sys_mmap(void);
+extern int sys_munmap(void);
+extern int sys_shm_open(void);
+extern int sys_shm_attach(void);
+extern int sys_shm_detach(void);
+extern int sys_futex_wait(void);
+extern int sys_futex_wake(void);
+extern int sys_yield(void);
+extern int sys_cpus_info(void);
+extern int sys_uptime_ns(void);
+extern int sys_ring_enter(void);
+extern int sys_syscall_latency(void);
+extern int sys_readtrace(void);
+extern int sys_profile(void);
+extern int sys_getrusage(void);
+extern int sys_getprocs(void);
+extern int sys_locktest(void);
+extern int sys_lseek(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -147,6 +176,25 @@ static int (*syscalls[])(void) = {
 [SYS_set_bc]                    sys_set_bc,
 [SYS_nsyscalls]                 sys_nsyscalls,
 [SYS_reentrantlocktest]         sys_reentrantlocktest,
+[SYS_spawn]                     sys_spawn,
+[SYS_mmap]                      sys_mmap,
+[SYS_munmap]                    sys_munmap,
+[SYS_shm_open]                  sys_shm_open,
+[SYS_shm_attach]                sys_shm_attach,
+[SYS_shm_detach]                sys_shm_detach,
+[SYS_futex_wait]                sys_futex_wait,
+[SYS_futex_wake]                sys_futex_wake,
+[SYS_yield]                     sys_yield,
+[SYS_cpus_info]                 sys_cpus_info,
+[SYS_uptime_ns]                 sys_uptime_ns,
+[SYS_ring_enter]                sys_ring_enter,
+[SYS_syscall_latency]           sys_syscall_latency,
+[SYS_readtrace]                 sys_readtrace,
+[SYS_profile]                   sys_profile,
+[SYS_getrusage]                 sys_getrusage,
+[SYS_getprocs]                  sys_getprocs,
+[SYS_locktest]                  sys_locktest,
+[SYS_lseek]                     sys_lseek,
 };
 
 static char *syscall_names[] = {
@@ -181,25 +229,65 @@ static char *syscall_names[] = {
   [SYS_set_bc]                    "set_bc",
   [SYS_nsyscalls]                 "sys_nsyscalls",
   [SYS_reentrantlocktest]         "sys_reentrantlocktest",
+  [SYS_spawn]                     "spawn",
+  [SYS_mmap]                      "mmap",
+  [SYS_munmap]                    "munmap",
+  [SYS_shm_open]                  "shm_open",
+  [SYS_shm_attach]                "shm_attach",
+  [SYS_shm_detach]                "shm_detach",
+  [SYS_futex_wait]                "futex_wait",
+  [SYS_futex_wake]                "futex_wake",
+  [SYS_yield]                     "yield",
+  [SYS_cpus_info]                 "cpus_info",
+  [SYS_uptime_ns]                 "uptime_ns",
+  [SYS_ring_enter]                "ring_enter",
+  [SYS_syscall_latency]           "syscall_latency",
+  [SYS_readtrace]                 "readtrace",
+  [SYS_profile]                   "profile",
+  [SYS_getrusage]                 "getrusage",
+  [SYS_getprocs]                  "getprocs",
+  [SYS_locktest]                  "locktest",
+  [SYS_lseek]                     "lseek",
 };
 
+// The name of system call num, or 0.
+char*
+syscallname(int num)
+{
+  if(num > 0 && num < NELEM(syscall_names))
+    return syscall_names[num];
+  return 0;
+}
+
+// Count a call that took t cycles.
+static void
+sysstat(struct sysstat *st, uint64 t)
+{
+  int b;
+
+  for(b = 0; b < NLATBUCKET-1 && (t >> (2*b+2)) != 0; b++)
+    ;
+  st->count++;
+  st->cycles += t;
+  st->lat[b]++;
+}
+
 void
 syscall(void)
 {
   int num;
+  uint64 start;
   struct proc *curproc = myproc();
 
   num = curproc->tf->eax;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
     // Track the system call
-    if (curproc->syscalls_count < MAX_SYSCALLS) {
-      curproc->syscall_num[curproc->syscalls_count] = num;
-      curproc->syscall_name[curproc->syscalls_count] = syscall_names[num];
-      curproc->syscall_invokes[num]++;
-      curproc->syscalls_count++;
-    }
-
+    curproc->syscalls_count++;
+    trace(TR_SYSENTER, curproc->pid, num, 0, syscall_names[num]);
+    start = rdtsc();
     curproc->tf->eax = syscalls[num]();
+    sysstat(&curproc->sysstat[num], rdtsc() - start);
+    trace(TR_SYSEXIT, curproc->pid, num, curproc->tf->eax, syscall_names[num]);
 
   } else {
     cprintf("%d %s: unknown sys call %d\n",
@@ -30,3 +30,22 @@
 #define SYS_set_bc 29
 #define SYS_nsyscalls 30
 #define SYS_reentrantlocktest 31
+#define SYS_spawn 32
+#define SYS_mmap 33
+#define SYS_munmap 34
+#define SYS_shm_open 35
+#define SYS_shm_attach 36
+#define SYS_shm_detach 37
+#define SYS_futex_wait 38
+#define SYS_futex_wake 39
+#define SYS_yield 40
+#define SYS_cpus_info 41
+#define SYS_uptime_ns 42
+#define SYS_ring_enter 43
+#define SYS_syscall_latency 44
+#define SYS_readtrace 45
+#define SYS_profile 46
+#define SYS_getrusage 47
+#define SYS_getprocs 48
+#define SYS_locktest 49
+#define SYS_lseek 50
@@ -0,0 +1,30 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+int main(int argc, char *argv[]) {
+  int pid, i;
+
+  if (argc > 2) {
+    printf(2, "Usage: syscall_latency [pid]\n");
+    exit();
+  }
+
+  // With no pid, report on some calls of our own.
+  if (argc == 2)
+    pid = atoi(argv[1]);
+  else {
+    pid = getpid();
+    for (i = 0; i < 1000; i++)
+      getpid();
+    for (i = 0; i < 100; i++)
+      write(1, "", 0);
+    sleep(1);
+  }
+
+  if (syscall_latency(pid) < 0) {
+    printf(2, "Error: Could not print system call latency for pid %d\n", pid);
+  }
+
+  exit();
+}
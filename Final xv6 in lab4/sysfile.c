@@ -16,6 +16,10 @@
 #include "reentrantlock.h"
 #include "file.h"
 #include "fcntl.h"
+#include "x86.h"
+#include "mman.h"
+#include "syscall.h"
+#include "ring.h"
 
 // Fetch the nth word-sized system call argument as a file descriptor
 // and return both the descriptor and the corresponding struct file.
@@ -76,6 +80,8 @@ sys_read(void)
 
   if(argfd(0, 0, &f) < 0 || argint(2, &n) < 0 || argptr(1, &p, n) < 0)
     return -1;
+  if(uvmtouch(myproc(), (uint)p, n, 1) < 0)
+    return -1;
   return fileread(f, p, n);
 }
 
@@ -104,6 +110,17 @@ sys_close(void)
   return 0;
 }
 
+int
+sys_lseek(void)
+{
+  struct file *f;
+  int off, whence;
+
+  if(argfd(0, 0, &f) < 0 || argint(1, &off) < 0 || argint(2, &whence) < 0)
+    return -1;
+  return fileseek(f, off, whence);
+}
+
 int
 sys_fstat(void)
 {
@@ -112,6 +129,8 @@ sys_fstat(void)
 
   if(argfd(0, 0, &f) < 0 || argptr(1, (void*)&st, sizeof(*st)) < 0)
     return -1;
+  if(uvmtouch(myproc(), (uint)st, sizeof(*st), 1) < 0)
+    return -1;
   return filestat(f, st);
 }
 
@@ -420,6 +439,67 @@ sys_exec(void)
   return exec(path, argv);
 }
 
+int
+sys_spawn(void)
+{
+  char *path, *argv[MAXARG];
+  int i, *fdmap;
+  uint uargv, uarg;
+
+  if(argstr(0, &path) < 0 || argint(1, (int*)&uargv) < 0 ||
+     argint(2, (int*)&fdmap) < 0){
+    return -1;
+  }
+  if(fdmap && argptr(2, (void*)&fdmap, NSPAWNFD*sizeof(fdmap[0])) < 0)
+    return -1;
+  memset(argv, 0, sizeof(argv));
+  for(i=0;; i++){
+    if(i >= NELEM(argv))
+      return -1;
+    if(fetchint(uargv+4*i, (int*)&uarg) < 0)
+      return -1;
+    if(uarg == 0){
+      argv[i] = 0;
+      break;
+    }
+    if(fetchstr(uarg, &argv[i]) < 0)
+      return -1;
+  }
+  return spawn(path, argv, fdmap);
+}
+
+int
+sys_mmap(void)
+{
+  int addr, len, prot, flags, fd, off;
+  struct file *f;
+
+  if(argint(0, &addr) < 0 || argint(1, &len) < 0 || argint(2, &prot) < 0 ||
+     argint(3, &flags) < 0 || argint(5, &off) < 0)
+    return -1;
+  if((flags & (MAP_SHARED|MAP_PRIVATE)) == 0 ||
+     (flags & (MAP_SHARED|MAP_PRIVATE)) == (MAP_SHARED|MAP_PRIVATE))
+    return -1;
+  f = 0;
+  if(!(flags & MAP_ANONYMOUS)){
+    if(argfd(4, &fd, &f) < 0 || f->type != FD_INODE || !f->readable)
+      return -1;
+    if((flags & MAP_SHARED) && (prot & PROT_WRITE) && !f->writable)
+      return -1;
+  }
+  return mmap(addr, len, prot, flags, f, off);
+}
+
+int
+sys_munmap(void)
+{
+  int addr, len;
+
+  if(argint(0, &addr) < 0 || argint(1, &len) < 0)
+    return -1;
+  return munmap(addr, len);
+}
+
 int
 sys_pipe(void)
 {
@@ -429,6 +509,8 @@ sys_pipe(void)
 
   if(argptr(0, (void*)&fd, 2*sizeof(fd[0])) < 0)
     return -1;
+  if(uvmtouch(myproc(), (uint)fd, 2*sizeof(fd[0]), 1) < 0)
+    return -1;
   if(pipealloc(&rf, &wf) < 0)
     return -1;
   fd0 = -1;
@@ -518,4 +600,53 @@ sys_reentrantlocktest(void)
   initreentrantlock(&lk);
   cprintf("Initiating lock: recursion = %d\n", lk.recursion);
   lock_and_call(3, &lk);
-}
\ No newline at end of file
+}
+
+// Run the system calls queued in a ring (see ring.h) in
+// order, each exactly as if the process had made it: it is
+// counted, and its arguments are fetched from the submission
+// by pointing the saved %esp at it.  Stops early if the
+// completion queue is full or the process is killed.
+// Returns the number of submissions run.
+int
+sys_ring_enter(void)
+{
+  struct proc *p = myproc();
+  struct ring *r;
+  struct sqe *sqe;
+  struct cqe *cqe;
+  uint esp, head, tail;
+  int n, num, res;
+
+  if(argptr(0, (char**)&r, sizeof(*r)) < 0 ||
+     uvmtouch(p, (uint)r, sizeof(*r), 1) < 0)
+    return -1;
+  head = r->sqhead;
+  tail = r->sqtail;
+  if(tail - head > NRING)
+    return -1;
+
+  esp = p->tf->esp;
+  for(n = 0; head + n != tail; n++){
+    if(r->cqtail - r->cqhead >= NRING || p->killed)
+      break;
+    sqe = &r->sq[(head + n) % NRING];
+    num = sqe->num;
+    if(num == SYS_read || num == SYS_write ||
+       num == SYS_open || num == SYS_close){
+      countsyscall(num);
+      p->tf->eax = num;
+      p->tf->esp = (uint)&sqe->num;  // in place of the return address
+      syscall();
+      res = p->tf->eax;
+    } else
+      res = -1;
+    cqe = &r->cq[r->cqtail % NRING];
+    cqe->data = sqe->data;
+    cqe->res = res;
+    r->cqtail++;
+    r->sqhead = head + n + 1;
+  }
+  p->tf->esp = esp;
+  return n;
+}
@@ -6,6 +6,11 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "trace.h"
+#include "prof.h"
+#include "rusage.h"
+#include "procinfo.h"
+#include "locktest.h"
 
 int sys_fork(void)
 {
@@ -84,6 +89,18 @@ int sys_uptime(void)
   return xticks;
 }
 
+// Store nanoseconds since boot in *ns.
+int sys_uptime_ns(void)
+{
+  uint64 *ns;
+
+  if (argptr(0, (void *)&ns, sizeof(*ns)) < 0 ||
+      uvmtouch(myproc(), (uint)ns, sizeof(*ns), 1) < 0)
+    return -1;
+  *ns = nsuptime();
+  return 0;
+}
+
 int sys_create_palindrome(void)
 {
   int num;
@@ -108,6 +125,14 @@ int sys_get_most_invoked_syscall(){
   return get_most_invoked_syscall(pid);
 }
 
+int sys_syscall_latency(void)
+{
+  int pid;
+  if (argint(0, &pid) < 0)
+    return -1;
+  return syscall_latency(pid);
+}
+
 int sys_list_all_processes(void){
   return list_all_processes();
 }
@@ -142,4 +167,131 @@ int sys_set_bc(void){
 int sys_nsyscalls(void){
   get_syscalls_num();
   return 0;
-}
\ No newline at end of file
+}
+
+int sys_shm_open(void)
+{
+  int key, size;
+  if (argint(0, &key) < 0 || argint(1, &size) < 0)
+    return -1;
+  return shmopen(key, size);
+}
+
+int sys_shm_attach(void)
+{
+  int id;
+  if (argint(0, &id) < 0)
+    return -1;
+  return shmattach(id);
+}
+
+int sys_shm_detach(void)
+{
+  int addr;
+  if (argint(0, &addr) < 0)
+    return -1;
+  return shmdetach(addr);
+}
+
+int sys_futex_wait(void)
+{
+  int addr, val;
+  if (argint(0, &addr) < 0 || argint(1, &val) < 0)
+    return -1;
+  return futexwait(addr, val);
+}
+
+int sys_futex_wake(void)
+{
+  int addr;
+  if (argint(0, &addr) < 0)
+    return -1;
+  return futexwake(addr);
+}
+
+int sys_yield(void)
+{
+  yield();
+  return 0;
+}
+
+int sys_cpus_info(void)
+{
+  cpus_info();
+  return 0;
+}
+
+int sys_readtrace(void)
+{
+  struct trace *buf;
+  int n;
+
+  if (argint(0, (int *)&buf) < 0 || argint(1, &n) < 0 || n < 0)
+    return -1;
+  if (buf == 0)
+    return readtrace(0, n);
+  if (n > NCPU * NTRACE)
+    n = NCPU * NTRACE;  // all there can be
+  if (argptr(0, (void *)&buf, n * sizeof(*buf)) < 0 ||
+      uvmtouch(myproc(), (uint)buf, n * sizeof(*buf), 1) < 0)
+    return -1;
+  return readtrace(buf, n);
+}
+
+int sys_profile(void)
+{
+  struct sample *buf;
+  int cmd, n;
+
+  if (argint(0, &cmd) < 0)
+    return -1;
+  if (cmd != PROF_DUMP)
+    return profile(cmd, 0, 0);
+  if (argint(2, &n) < 0 || n < 0)
+    return -1;
+  if (n > NCPU * NPROFSAMPLE)
+    n = NCPU * NPROFSAMPLE;  // all there can be
+  if (argptr(1, (void *)&buf, n * sizeof(*buf)) < 0 ||
+      uvmtouch(myproc(), (uint)buf, n * sizeof(*buf), 1) < 0)
+    return -1;
+  return profile(cmd, buf, n);
+}
+
+int sys_getrusage(void)
+{
+  struct rusage *ru;
+  int pid;
+
+  if (argint(0, &pid) < 0 ||
+      argptr(1, (void *)&ru, sizeof(*ru)) < 0 ||
+      uvmtouch(myproc(), (uint)ru, sizeof(*ru), 1) < 0)
+    return -1;
+  return getrusage(pid, ru);
+}
+
+int sys_getprocs(void)
+{
+  char *buf;
+  int n;
+
+  if (argint(1, &n) < 0 || n < 0)
+    return -1;
+  if (n > NPROC)
+    n = NPROC;
+  if (argptr(0, &buf, n * sizeof(struct procinfo)) < 0 ||
+      uvmtouch(myproc(), (uint)buf, n * sizeof(struct procinfo), 1) < 0)
+    return -1;
+  return getprocs((uint)buf, n);
+}
+
+int sys_locktest(void)
+{
+  struct ltresult *r;
+  int kind, ms, cs;
+
+  if (argint(0, &kind) < 0 || argint(1, &ms) < 0 || argint(2, &cs) < 0 ||
+      argptr(3, (void *)&r, sizeof(*r)) < 0 ||
+      uvmtouch(myproc(), (uint)r, sizeof(*r), 1) < 0)
+    return -1;
+  return locktest(kind, ms, cs, r);
+}
@@ -0,0 +1,85 @@
+// Show the processes every few ticks, busiest first, with the
+// share of one CPU each used since the previous round.
+//
+//   top [ticks [rounds]]    default: every 100 ticks, 5 rounds
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "x86.h"
+#include "procinfo.h"
+
+static struct procinfo pi[NPROC];
+static int busy[NPROC];             // microseconds this round, by pi[] index
+static int lastpid[NPROC];          // pid and CPU time at the last round
+static uint lastcpu[NPROC];
+static char *states[] = { "unused", "embryo", "sleep", "runble", "run", "zombie" };
+static char *queues[] = { "RR", "SJF", "FCFS" };
+
+// pi[i]'s CPU time since the last round, then remember it.
+static uint
+since(int i, int nlast)
+{
+  uint cpu = pi[i].utime + pi[i].stime;
+  int j;
+
+  for(j = 0; j < nlast; j++)
+    if(lastpid[j] == pi[i].pid)
+      return cpu - lastcpu[j];
+  return cpu;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int ticks, rounds, n, nlast, r, i, j, order[NPROC], k;
+  uint64 start;
+  uint us;
+
+  ticks = argc > 1 ? atoi(argv[1]) : 100;
+  rounds = argc > 2 ? atoi(argv[2]) : 5;
+  if(ticks <= 0 || rounds <= 0){
+    printf(2, "usage: top [ticks [rounds]]\n");
+    exit();
+  }
+
+  nlast = 0;
+  start = nsec();
+  for(r = 0; r < rounds; r++){
+    sleep(ticks);
+    us = usecsince(start);
+    start = nsec();
+    if((n = getprocs(pi, NPROC)) < 0){
+      printf(2, "top: getprocs failed\n");
+      exit();
+    }
+    for(i = 0; i < n; i++)
+      busy[i] = since(i, nlast);
+    for(i = 0; i < n; i++){
+      lastpid[i] = pi[i].pid;
+      lastcpu[i] = pi[i].utime + pi[i].stime;
+    }
+    nlast = n;
+
+    // Busiest first.
+    for(i = 0; i < n; i++){
+      k = i;
+      for(j = i; j > 0 && busy[order[j-1]] < busy[k]; j--)
+        order[j] = order[j-1];
+      order[j] = k;
+    }
+
+    printf(1, "\n%d processes, %d ms\n", n, us / 1000);
+    printf(1, "pid\tppid\tstate\tqueue\tcpu%%\tuser ms\tsys ms\tmem kb\tcalls\tname\n");
+    for(j = 0; j < n; j++){
+      i = order[j];
+      printf(1, "%d\t%d\t%s\t%s\t%d\t%d\t%d\t%d\t%d\t%s\n",
+             pi[i].pid, pi[i].ppid, states[pi[i].state], queues[pi[i].queue],
+             us ? divq((uint64)busy[i] * 100, us, 0) : 0,
+             pi[i].utime / 1000, pi[i].stime / 1000, pi[i].sz / 1024,
+             pi[i].syscalls, pi[i].name);
+    }
+  }
+  exit();
+}
@@ -0,0 +1,110 @@
+// Kernel event tracing.
+//
+// Each CPU appends struct trace records to its own ring, with
+// interrupts off and no lock, so tracing costs little and does
+// not serialize CPUs the way cprintf() does.  readtrace()
+// collects the records; it copies a ring while that ring's
+// CPU may still be writing to it, then drops whatever could
+// have been overwritten meanwhile.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "proc.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "trace.h"
+
+struct tracebuf {
+  volatile uint head;  // records ever written; the next goes at head % NTRACE
+  uint tail;           // records already collected by readtrace()
+  struct trace rec[NTRACE];
+};
+
+static struct tracebuf tracebuf[NCPU];
+static struct spinlock tracelock;  // serializes readtrace()
+int tracing;                       // record events only if set
+
+void
+traceinit(void)
+{
+  initlock(&tracelock, "trace");
+}
+
+// Record an event on this CPU.  name, if not 0, is copied
+// into the record.
+void
+trace(int type, int a, int b, int c, char *name)
+{
+  struct tracebuf *tb;
+  struct trace *t;
+
+  if(!tracing)
+    return;
+  pushcli();
+  tb = &tracebuf[cpuid()];
+  t = &tb->rec[tb->head % NTRACE];
+  t->tsc = rdtsc();
+  t->cpu = cpuid();
+  t->type = type;
+  t->a = a;
+  t->b = b;
+  t->c = c;
+  strncpy(t->name, name ? name : "", sizeof(t->name));
+  __sync_synchronize();  // the record is complete before head moves
+  tb->head++;
+  popcli();
+}
+
+// Copy up to n records, oldest first per CPU, that have not
+// been collected yet into buf, which the caller has checked
+// and faulted in for writing.  Returns the number copied.
+// If buf is 0, turn tracing off (n == 0), or on, dropping
+// anything uncollected.
+int
+readtrace(struct trace *buf, int n)
+{
+  struct tracebuf *tb;
+  uint head, cnt, lost, i;
+  int got;
+
+  acquire(&tracelock);
+  if(buf == 0){
+    if(n)
+      for(tb = tracebuf; tb < &tracebuf[ncpu]; tb++)
+        tb->tail = tb->head;
+    tracing = n != 0;
+    release(&tracelock);
+    return 0;
+  }
+
+  got = 0;
+  for(tb = tracebuf; tb < &tracebuf[ncpu] && got < n; tb++){
+    // The slot at head % NTRACE may be half rewritten, so
+    // only the NTRACE-1 records before it are intact.
+    head = tb->head;
+    __sync_synchronize();
+    if(head - tb->tail >= NTRACE)
+      tb->tail = head - NTRACE + 1;
+    cnt = head - tb->tail;
+    if(cnt > (uint)(n - got))
+      cnt = n - got;
+    for(i = 0; i < cnt; i++)
+      buf[got + i] = tb->rec[(tb->tail + i) % NTRACE];
+    __sync_synchronize();
+
+    // Drop the oldest records if the writer lapped us meanwhile.
+    head = tb->head;
+    lost = 0;
+    if(head - tb->tail >= NTRACE)
+      lost = head - tb->tail - NTRACE + 1;
+    if(lost > cnt)
+      lost = cnt;
+    memmove(buf + got, buf + got + lost, (cnt - lost) * sizeof(*buf));
+    tb->tail += cnt;
+    got += cnt - lost;
+  }
+  release(&tracelock);
+  return got;
+}
@@ -0,0 +1,19 @@
+// Binary records of kernel events, as returned by readtrace().
+
+#define TR_SWITCH   1  // CPU switched from pid a to pid b (0: scheduler);
+                       // c is a's state, name is b's
+#define TR_WAKEUP   2  // pid a became runnable in queue b
+#define TR_QUEUE    3  // pid a (0: the CPU's own turn) moved from
+                       // queue b to queue c
+#define TR_SYSENTER 4  // pid a made system call b, named name
+#define TR_SYSEXIT  5  // ... which returned c
+#define TR_LOCK     6  // pid a spun b times to acquire lock name
+
+struct trace {
+  uint64 tsc;    // rdtsc() when it happened
+  uchar cpu;     // where it happened
+  uchar type;    // TR_*
+  ushort pad;
+  int a, b, c;
+  char name[8];  // not nul-terminated if 8 long
+};
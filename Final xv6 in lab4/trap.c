@@ -8,10 +8,13 @@
 #include "traps.h"
 #include "syscall.h"
 #include "spinlock.h"
+#include "vdso.h"
+#include "trace.h"
 
 // Interrupt descriptor table (shared by all CPUs).
 struct gatedesc idt[256];
 extern uint vectors[];  // in vectors.S: array of 256 entry pointers
+extern char sysenter[]; // in trapasm.S
 struct spinlock tickslock;
 uint ticks;
 int total_syscall;
@@ -30,63 +33,91 @@ tvinit(void)
   initlock(&tickslock, "time");
 }
 
+// Load this CPU's trap entry points: the IDT, and the
+// sysenter entry, whose stack is this CPU's ts.esp0.
 void
 idtinit(void)
 {
   lidt(idt, sizeof(idt));
+  wrmsr(MSR_SYSENTER_CS, SEG_KCODE<<3);
+  wrmsr(MSR_SYSENTER_ESP, (uint)&mycpu()->ts.esp0);
+  wrmsr(MSR_SYSENTER_EIP, (uint)sysenter);
+}
+
+// Count system call num against this CPU and the total.
+void
+countsyscall(int num)
+{
+  int cost_syscall = 1;
+  if (num == SYS_write){
+    cli();
+    mycpu()->syscallnum += 2;
+    sti();
+    cost_syscall = 2;
+  }
+  else if (num == SYS_open){
+    cli();
+    mycpu()->syscallnum += 3;
+    sti();
+    cost_syscall = 3;
+  }
+  else{
+    cli();
+    mycpu()->syscallnum++;
+    sti();
+  }
+  acquire(&nsyscall_lock);
+  total_syscall += cost_syscall;
+  release(&nsyscall_lock);
+}
+
+// Handle a system call, from int $T_SYSCALL by way of trap(),
+// or straight from sysenter in trapasm.S.
+void
+systrap(struct trapframe *tf)
+{
+  chargetime(myproc(), 1);
+  if(myproc()->killed)
+    exit();
+  myproc()->tf = tf;
+  countsyscall(tf->eax);
+  syscall();
+  if(myproc()->killed)
+    exit();
+  chargetime(myproc(), 0);
 }
 
 //PAGEBREAK: 41
 void
 trap(struct trapframe *tf)
 {
+  int resched;
+
   if(tf->trapno == T_SYSCALL){
-    if(myproc()->killed)
-      exit();
-    myproc()->tf = tf;
-    int cost_syscall = 1;
-    // if (tf->eax == SYS_write)
-    //   cprintf("amoooooooo\n");
-    if (tf->eax == SYS_write){
-      cli();
-      mycpu()->syscallnum += 2;
-      sti(); 
-      cost_syscall = 2;
-    }
-    else if (tf->eax == SYS_open){
-      cli();
-      mycpu()->syscallnum += 3;
-      sti();
-      cost_syscall = 3;
-    }
-    else{
-      cli();
-      mycpu()->syscallnum++;
-      sti();
-    }
-    acquire(&nsyscall_lock);
-    total_syscall += cost_syscall;
-    release(&nsyscall_lock);
-    syscall();
-    if(myproc()->killed)
-      exit();
+    systrap(tf);
     return;
   }
+  if(myproc() && (tf->cs&3) == DPL_USER)
+    chargetime(myproc(), 1);
 
   switch(tf->trapno){
   case T_IRQ0 + IRQ_TIMER:
+    mycpu()->nticks++;
+    if(profiling)
+      profsample(tf);
     if(cpuid() == 0){
       acquire(&tickslock);
       ticks++;
+      vdso->ticks = ticks;
       age_processes();
       add_consecutive();
       wakeup(&ticks);
       release(&tickslock);
     }
-    // if (myproc() != 0)
-    //   cprintf("cpu:%d tick:%d pid:%d queue:%d arrival:%d\n", cpuid(), ticks, myproc()->pid, myproc()->schedqueue, myproc()->arraival);
-    // else
-    //   cprintf("cpu:%d tick:%d proc:%d queue:%d\n", cpuid(), ticks, mycpu()->proc, mycpu()->schedqueue);
+    lapiceoi();
+    break;
+  case T_IRQ0 + IRQ_RESCHED:
+    // Woken out of hlt(), or asked to preempt (see below).
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -111,6 +142,14 @@ trap(struct trapframe *tf)
     lapiceoi();
     break;
 
+  case T_PGFLT:
+    // Page not loaded yet, or a shared page being written:
+    // let the VM system fix the mapping and retry the access.
+    if(myproc() && rcr2() < KERNBASE &&
+       uvmfault(myproc(), rcr2(), tf->err & FEC_WR) == 0)
+      break;
+    // fall through
+
   //PAGEBREAK: 13
   default:
     if(myproc() == 0 || (tf->cs&3) == 0){
@@ -135,20 +174,47 @@ trap(struct trapframe *tf)
 
   // Force process to give up CPU on clock tick.
   // If interrupts were on while locks held, would need to check nlock.
-  if(myproc() && myproc()->state == RUNNING &&
-     tf->trapno == T_IRQ0+IRQ_TIMER){
-    mycpu()->queueticks++;
-    if((mycpu()->schedqueue == RR   && mycpu()->queueticks == 30) ||
-       (mycpu()->schedqueue == SJF  && mycpu()->queueticks == 20) ||
-       (mycpu()->schedqueue == FCFS && mycpu()->queueticks == 10)){
-      mycpu()->schedqueue = (mycpu()->schedqueue + 1) % NSCHEDQUEUE;
-      mycpu()->queueticks = 0;
+  // Other than CPU 0, a CPU's timer fires only when the next of
+  // these events is due (see armtimer), having counted armed ticks.
+  if(tf->trapno == T_IRQ0+IRQ_TIMER){
+    resched = 0;
+    if(myproc() && myproc()->state == RUNNING){
+      mycpu()->queueticks += mycpu()->armed ? mycpu()->armed : 1;
+      if((mycpu()->schedqueue == RR   && mycpu()->queueticks >= RRTICKS) ||
+         (mycpu()->schedqueue == SJF  && mycpu()->queueticks >= SJFTICKS) ||
+         (mycpu()->schedqueue == FCFS && mycpu()->queueticks >= FCFSTICKS)){
+        trace(TR_QUEUE, 0, mycpu()->schedqueue,
+              (mycpu()->schedqueue + 1) % NSCHEDQUEUE, 0);
+        mycpu()->schedqueue = (mycpu()->schedqueue + 1) % NSCHEDQUEUE;
+        mycpu()->queueticks = 0;
+        resched = 1;
+      } else if(mycpu()->schedqueue == RR &&
+                mycpu()->queueticks % RRQUANTUM == 0)
+        resched = 1;
+    }
+    armtimer();
+    if(resched)
       yield();
-    } else if(mycpu()->schedqueue == RR && mycpu()->queueticks % 5 == 0)
+  }
+
+  // RR work became runnable while this CPU ran a lower queue:
+  // cut the current queue's turn short.
+  if(tf->trapno == T_IRQ0+IRQ_RESCHED && mycpu()->preempt){
+    mycpu()->preempt = 0;
+    if(myproc() && myproc()->state == RUNNING &&
+       myproc()->schedqueue != RR){
+      trace(TR_QUEUE, 0, mycpu()->schedqueue, RR, 0);
+      mycpu()->schedqueue = RR;
+      mycpu()->queueticks = 0;
+      armtimer();
       yield();
+    }
   }
 
   // Check if the process has been killed since we yielded
   if(myproc() && myproc()->killed && (tf->cs&3) == DPL_USER)
     exit();
+
+  if(myproc() && (tf->cs&3) == DPL_USER)
+    chargetime(myproc(), 0);
 }
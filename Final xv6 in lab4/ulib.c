@@ -3,6 +3,7 @@
 #include "fcntl.h"
 #include "user.h"
 #include "x86.h"
+#include "vdso.h"
 
 char*
 strcpy(char *s, const char *t)
@@ -104,3 +105,96 @@ memmove(void *vdst, const void *vsrc, int n)
     *dst++ = *src++;
   return vdst;
 }
+
+// getpid() without a system call, from the vdso.h page.
+int
+vgetpid(void)
+{
+  return ((struct vdsoproc*)VDSOPROC)->pid;
+}
+
+// uptime() without a system call, from the vdso.h page.
+uint
+vuptime(void)
+{
+  return ((struct vdsotime*)VDSOTIME)->ticks;
+}
+
+// Nanoseconds since boot, as uptime_ns() returns, but
+// computed from the TSC and the vdso.h page.
+uint64
+nsec(void)
+{
+  struct vdsotime *vt = (struct vdsotime*)VDSOTIME;
+  uint64 ns;
+  uint ms, rem;
+
+  if(vt->tsckhz == 0){
+    if(uptime_ns(&ns) < 0)
+      return 0;
+    return ns;
+  }
+  ms = divq(rdtsc() - vt->tscboot, vt->tsckhz, &rem);
+  return (uint64)ms * 1000000 + divq((uint64)rem * 1000000, vt->tsckhz, 0);
+}
+
+// Microseconds from start, an earlier nsec(), until now.
+uint
+usecsince(uint64 start)
+{
+  return divq(nsec() - start, 1000, 0);
+}
+
+// Report that what failed in program prog, and exit.
+void
+fail(char *prog, char *what)
+{
+  printf(1, "%s: %s failed\n", prog, what);
+  exit();
+}
+
+// Print x thousandths as a decimal.
+void
+fixed(uint x)
+{
+  uint f;
+
+  f = x % 1000;
+  printf(1, "%d.%s%s%d", x / 1000, f < 100 ? "0" : "", f < 10 ? "0" : "", f);
+}
+
+// Jain's fairness index (sum x)^2 / (n * sum x^2) of n shares,
+// given their sum and sum of squares, in thousandths.
+uint
+jain(uint64 sum, uint64 sumsq, uint n)
+{
+  uint64 num, den;
+
+  if(n == 0 || sumsq == 0)
+    return 1000;
+  num = sum * sum * 1000;
+  den = sumsq * n;
+  while(den >> 32){  // divq() takes a 32-bit divisor
+    num >>= 1;
+    den >>= 1;
+  }
+  return divq(num, den, 0);
+}
+
+// Upper bound of the value that pct percent of the n samples in
+// histogram hist[0..nb-1] did not exceed, where bucket b counts
+// values below 2^(b+1).
+uint64
+percentile(uint *hist, int nb, uint n, uint pct)
+{
+  uint64 sum;
+  int b;
+
+  sum = 0;
+  for(b = 0; b < nb - 1; b++){
+    sum += hist[b];
+    if(sum * 100 >= (uint64)n * pct)
+      break;
+  }
+  return (uint64)2 << b;
+}
@@ -1,5 +1,11 @@
 struct stat;
 struct rtcdate;
+struct ring;
+struct trace;
+struct sample;
+struct rusage;
+struct procinfo;
+struct ltresult;
 
 // system calls
 int fork(void);
@@ -33,6 +39,25 @@ int processes_info(void);
 int set_bc(int, int, int);
 int nsyscalls(void);
 void reentrantlocktest(void);
+int spawn(char *, char **, int *);
+void *mmap(void *, uint, int, int, int, uint);
+int munmap(void *, uint);
+int shm_open(int, uint);
+void *shm_attach(int);
+int shm_detach(void *);
+int futex_wait(int *, int);
+int futex_wake(int *);
+int yield(void);
+int cpus_info(void);
+int uptime_ns(uint64 *);
+int ring_enter(struct ring *);
+int syscall_latency(int);
+int readtrace(struct trace *, int);
+int profile(int, struct sample *, int);
+int getrusage(int, struct rusage *);
+int getprocs(struct procinfo *, int);
+int locktest(int, int, int, struct ltresult *);
+int lseek(int, int, int);
 
 
 // ulib.c
@@ -48,3 +73,11 @@ void *memset(void *, int, uint);
 void *malloc(uint);
 void free(void *);
 int atoi(const char *);
+int vgetpid(void);
+uint vuptime(void);
+uint64 nsec(void);
+uint usecsince(uint64);
+void fail(char*, char*);
+void fixed(uint);
+uint jain(uint64, uint64, uint);
+uint64 percentile(uint*, int, uint, uint);
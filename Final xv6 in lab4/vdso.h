@@ -0,0 +1,17 @@
+// Read-only pages that the kernel maps at the top of every
+// process's memory, so that user code can read them instead of
+// making a system call.  See vdsofault() in vm.c and nsec()
+// in ulib.c.
+
+#define VDSOTIME 0x7FFFE000  // struct vdsotime, shared by everyone
+#define VDSOPROC 0x7FFFF000  // struct vdsoproc, one per process
+
+struct vdsotime {
+  volatile uint ticks;  // as returned by uptime()
+  uint tsckhz;          // TSC cycles per millisecond, 0 if unknown
+  uint64 tscboot;       // TSC at 0 nanoseconds of uptime_ns()
+};
+
+struct vdsoproc {
+  int pid;              // as returned by getpid()
+};
@@ -0,0 +1,67 @@
+// Compare getpid(), uptime() and uptime_ns() against their
+// vdso.h counterparts, which read a page instead of trapping.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+
+#define N 100000
+
+int
+main(void)
+{
+  uint64 start, ns;
+  uint sys, vdso;
+  int i;
+
+  if(vgetpid() != getpid()){
+    printf(1, "vdsobench: vgetpid %d, getpid %d\n", vgetpid(), getpid());
+    exit();
+  }
+  if(vuptime() > uptime()){
+    printf(1, "vdsobench: vuptime %d ahead of uptime %d\n", vuptime(), uptime());
+    exit();
+  }
+
+  start = nsec();
+  for(i = 0; i < N; i++)
+    getpid();
+  sys = usecsince(start);
+  start = nsec();
+  for(i = 0; i < N; i++)
+    vgetpid();
+  vdso = usecsince(start);
+  printf(1, "getpid: %d ns syscall, %d ns vdso\n",
+         divq((uint64)sys * 1000, N, 0), divq((uint64)vdso * 1000, N, 0));
+
+  start = nsec();
+  for(i = 0; i < N; i++)
+    uptime();
+  sys = usecsince(start);
+  start = nsec();
+  for(i = 0; i < N; i++)
+    vuptime();
+  vdso = usecsince(start);
+  printf(1, "uptime: %d ns syscall, %d ns vdso\n",
+         divq((uint64)sys * 1000, N, 0), divq((uint64)vdso * 1000, N, 0));
+
+  start = nsec();
+  for(i = 0; i < N; i++)
+    uptime_ns(&ns);
+  sys = usecsince(start);
+  start = nsec();
+  for(i = 0; i < N; i++)
+    nsec();
+  vdso = usecsince(start);
+  printf(1, "uptime_ns: %d ns syscall, %d ns vdso\n",
+         divq((uint64)sys * 1000, N, 0), divq((uint64)vdso * 1000, N, 0));
+
+  if(fork() == 0){
+    if(vgetpid() != getpid())
+      printf(1, "vdsobench: child vgetpid %d, getpid %d\n", vgetpid(), getpid());
+    exit();
+  }
+  wait();
+  exit();
+}
@@ -6,10 +6,46 @@
 #include "mmu.h"
 #include "proc.h"
 #include "elf.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+#include "mman.h"
+#include "vdso.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
 
+// Pages of executables, shared read-only by every process
+// running the same binary.  Each entry holds a reference to
+// its page; a process writing to one gets a private copy.
+struct {
+  struct spinlock lock;
+  struct {
+    uint dev;
+    uint inum;
+    uint off;   // file offset of the page
+    uint n;     // bytes read from the file, the rest is zero
+    char *mem;  // 0 if the slot is free
+  } pg[NTEXTPG];
+  int victim;   // next slot to recycle when all are in use
+} textcache;
+
+// Pages of files mapped MAP_SHARED, so that every process
+// mapping a page of a file maps the same memory.  Each entry
+// holds a reference to its page; once nobody else refers to it
+// the entry is stale, since the file may have changed, and is
+// dropped.
+struct {
+  struct spinlock lock;
+  struct {
+    uint dev;
+    uint inum;
+    uint off;   // file offset of the page
+    char *mem;  // 0 if the slot is free
+  } pg[NMAPPG];
+} mapcache;
+
 // Set up CPU's kernel segment descriptors.
 // Run once on entry on each CPU.
 void
@@ -31,7 +67,8 @@ seginit(void)
 
 // Return the address of the PTE in page table pgdir
 // that corresponds to virtual address va.  If alloc!=0,
-// create any required page table pages.
+// create any required page table pages.  Returns 0 for an
+// address in a superpage, which has no page table.
 static pte_t *
 walkpgdir(pde_t *pgdir, const void *va, int alloc)
 {
@@ -39,6 +76,8 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
   pte_t *pgtab;
 
   pde = &pgdir[PDX(va)];
+  if(*pde & PTE_PS)
+    return 0;
   if(*pde & PTE_P){
     pgtab = (pte_t*)P2V(PTE_ADDR(*pde));
   } else {
@@ -79,8 +118,26 @@ mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
   return 0;
 }
 
+// Map [va, va+size) to physical addresses starting at pa with
+// 4MB superpages, straight from the page directory.  va, size
+// and pa must be superpage-aligned.
+static void
+mapsuper(pde_t *pgdir, void *va, uint size, uint pa, int perm)
+{
+  uint a;
+
+  if((uint)va % SPGSIZE || size % SPGSIZE || pa % SPGSIZE)
+    panic("mapsuper: not aligned");
+  for(a = 0; a != size; a += SPGSIZE){
+    if(pgdir[PDX((uint)va + a)] & PTE_P)
+      panic("remap");
+    pgdir[PDX((uint)va + a)] = (pa + a) | perm | PTE_P | PTE_PS;
+  }
+}
+
 // There is one page table per process, plus one that's used when
-// a CPU is not running any process (kpgdir). The kernel uses the
+// a CPU is not running any process (kpgdir).  All of them share
+// kpgdir's kernel half, built once at boot. The kernel uses the
 // current process's page table during system calls and interrupts;
 // page protection bits prevent user code from using the kernel's
 // mappings.
@@ -96,6 +153,13 @@ mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
 //                                  rw data + free physical memory
 //   0xfe000000..0: mapped direct (devices such as ioapic)
 //
+// Only the first 4MB of the kernel map, which holds the kernel
+// itself, uses 4KB pages, so that the text can be read-only.
+// Everything above it is mapped with 4MB superpages (PTE_PS),
+// which need no page-table pages and fewer TLB entries.
+// All kernel mappings are global (PTE_G): they are the same in
+// every page table, so they stay in the TLB when %cr3 changes.
+//
 // The kernel allocates physical memory for its heap and for user memory
 // between V2P(end) and the end of physical memory (PHYSTOP)
 // (directly addressable from end..P2V(PHYSTOP)).
@@ -108,48 +172,83 @@ static struct kmap {
   uint phys_end;
   int perm;
 } kmap[] = {
- { (void*)KERNBASE, 0,             EXTMEM,    PTE_W}, // I/O space
- { (void*)KERNLINK, V2P(KERNLINK), V2P(data), 0},     // kern text+rodata
- { (void*)data,     V2P(data),     PHYSTOP,   PTE_W}, // kern data+memory
- { (void*)DEVSPACE, DEVSPACE,      0,         PTE_W}, // more devices
+ { (void*)KERNBASE, 0,             EXTMEM,    PTE_W|PTE_G}, // I/O space
+ { (void*)KERNLINK, V2P(KERNLINK), V2P(data), PTE_G},       // kern text+rodata
+ { (void*)data,     V2P(data),     SPGSIZE,   PTE_W|PTE_G}, // kern data+memory
+ { P2V(SPGSIZE),    SPGSIZE,       PHYSTOP,   PTE_W|PTE_G|PTE_PS}, // memory
+ { (void*)DEVSPACE, DEVSPACE,      0,         PTE_W|PTE_G|PTE_PS}, // devices
 };
 
-// Set up kernel part of a page table.
+// Set up kernel part of a page table.  The kernel half of
+// kpgdir never changes after boot, so its page-table pages are
+// shared by pointer rather than rebuilt.
 pde_t*
 setupkvm(void)
 {
   pde_t *pgdir;
-  struct kmap *k;
 
   if((pgdir = (pde_t*)kalloc()) == 0)
     return 0;
-  memset(pgdir, 0, PGSIZE);
-  if (P2V(PHYSTOP) > (void*)DEVSPACE)
-    panic("PHYSTOP too high");
-  for(k = kmap; k < &kmap[NELEM(kmap)]; k++)
-    if(mappages(pgdir, k->virt, k->phys_end - k->phys_start,
-                (uint)k->phys_start, k->perm) < 0) {
-      freevm(pgdir);
-      return 0;
-    }
+  memset(pgdir, 0, PDX(KERNBASE) * sizeof(pde_t));
+  memmove(&pgdir[PDX(KERNBASE)], &kpgdir[PDX(KERNBASE)],
+          (NPDENTRIES - PDX(KERNBASE)) * sizeof(pde_t));
   return pgdir;
 }
 
 // Allocate one page table for the machine for the kernel address
-// space for scheduler processes.
+// space for scheduler processes.  Its kernel half is the one
+// every other page table uses.
 void
 kvmalloc(void)
 {
-  kpgdir = setupkvm();
+  struct kmap *k;
+
+  if((kpgdir = (pde_t*)kalloc()) == 0)
+    panic("kvmalloc");
+  memset(kpgdir, 0, PGSIZE);
+  if (P2V(PHYSTOP) > (void*)DEVSPACE)
+    panic("PHYSTOP too high");
+  if (V2P(data) > SPGSIZE)
+    panic("kernel too big");
+  for(k = kmap; k < &kmap[NELEM(kmap)]; k++){
+    if(k->perm & PTE_PS)
+      mapsuper(kpgdir, k->virt, k->phys_end - k->phys_start,
+               (uint)k->phys_start, k->perm);
+    else if(mappages(kpgdir, k->virt, k->phys_end - k->phys_start,
+                     (uint)k->phys_start, k->perm) < 0)
+      panic("kvmalloc: out of memory");
+  }
   switchkvm();
 }
 
+// Load pgdir into %cr3.  While a CPU has a process's page table
+// loaded it holds a reference to it, so that the page stays a
+// valid page directory even after the process is freed: the
+// scheduler keeps running on the last process's page table
+// rather than switching back to kpgdir.  Interrupts must be off.
+static void
+loadpgdir(pde_t *pgdir)
+{
+  struct cpu *c = mycpu();
+  pde_t *old;
+
+  old = c->pgdir;
+  if(pgdir != kpgdir)
+    kref((char*)pgdir);
+  lcr3(V2P(pgdir));
+  c->pgdir = pgdir != kpgdir ? pgdir : 0;
+  if(old)
+    kfree((char*)old);
+}
+
 // Switch h/w page table register to the kernel-only page table,
 // for when no process is running.
 void
 switchkvm(void)
 {
-  lcr3(V2P(kpgdir));   // switch to the kernel page table
+  pushcli();
+  loadpgdir(kpgdir);   // switch to the kernel page table
+  popcli();
 }
 
 // Switch TSS and h/w page table to correspond to process p.
@@ -173,7 +272,7 @@ switchuvm(struct proc *p)
   // forbids I/O instructions (e.g., inb and outb) from user space
   mycpu()->ts.iomb = (ushort) 0xFFFF;
   ltr(SEG_TSS << 3);
-  lcr3(V2P(p->pgdir));  // switch to process's address space
+  loadpgdir(p->pgdir);  // switch to process's address space
   popcli();
 }
 
@@ -279,19 +378,22 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 }
 
 // Free a page table and all the physical memory pages
-// in the user part.
+// in the user part.  The kernel half belongs to kpgdir.
+// Another CPU may still have pgdir loaded (see loadpgdir), so
+// the user half is emptied before its tables are freed.
 void
 freevm(pde_t *pgdir)
 {
   uint i;
+  pde_t pde;
 
   if(pgdir == 0)
     panic("freevm: no pgdir");
   deallocuvm(pgdir, KERNBASE, 0);
-  for(i = 0; i < NPDENTRIES; i++){
-    if(pgdir[i] & PTE_P){
-      char * v = P2V(PTE_ADDR(pgdir[i]));
-      kfree(v);
+  for(i = 0; i < PDX(KERNBASE); i++){
+    if((pde = pgdir[i]) & PTE_P){
+      pgdir[i] = 0;
+      kfree(P2V(PTE_ADDR(pde)));
     }
   }
   kfree((char*)pgdir);
@@ -323,12 +425,23 @@ copyuvm(pde_t *pgdir, uint sz)
   if((d = setupkvm()) == 0)
     return 0;
   for(i = 0; i < sz; i += PGSIZE){
-    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
-      panic("copyuvm: pte should exist");
+    // Pages that were never touched have not been allocated
+    // yet; the child will fault them in itself.
+    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0){
+      i = PGADDR(PDX(i) + 1, 0, 0) - PGSIZE;
+      continue;
+    }
     if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
+      continue;
     pa = PTE_ADDR(*pte);
     flags = PTE_FLAGS(*pte);
+    if(flags & PTE_COW){
+      // Already shared and read-only: share it with the child too.
+      if(mappages(d, (void*)i, PGSIZE, pa, flags) < 0)
+        goto bad;
+      kref(P2V(pa));
+      continue;
+    }
     if((mem = kalloc()) == 0)
       goto bad;
     memmove(mem, (char*)P2V(pa), PGSIZE);
@@ -344,6 +457,693 @@ bad:
   return 0;
 }
 
+void
+textinit(void)
+{
+  initlock(&textcache.lock, "textcache");
+  initlock(&mapcache.lock, "mapcache");
+}
+
+// Forget the cached pages of ip, whose contents are changing.
+// Processes that already map them keep the old data.
+void
+textinval(struct inode *ip)
+{
+  int i;
+
+  acquire(&textcache.lock);
+  for(i = 0; i < NTEXTPG; i++){
+    if(textcache.pg[i].mem && textcache.pg[i].dev == ip->dev &&
+       textcache.pg[i].inum == ip->inum){
+      kfree(textcache.pg[i].mem);
+      textcache.pg[i].mem = 0;
+    }
+  }
+  release(&textcache.lock);
+}
+
+// Return the page holding n bytes of ip at offset off followed
+// by zeroes, reading it only if no process has it yet.  The
+// caller gets its own reference to the page.
+static char*
+textpage(struct inode *ip, uint off, uint n)
+{
+  int i, slot;
+  char *mem, *old;
+
+  acquire(&textcache.lock);
+  for(i = 0; i < NTEXTPG; i++){
+    if(textcache.pg[i].mem && textcache.pg[i].dev == ip->dev &&
+       textcache.pg[i].inum == ip->inum && textcache.pg[i].off == off &&
+       textcache.pg[i].n == n){
+      mem = textcache.pg[i].mem;
+      kref(mem);
+      release(&textcache.lock);
+      return mem;
+    }
+  }
+  release(&textcache.lock);
+
+  if((mem = kalloc()) == 0)
+    return 0;
+  memset(mem, 0, PGSIZE);
+  ilock(ip);
+  i = readi(ip, mem, off, n);
+  iunlock(ip);
+  if(i != n){
+    kfree(mem);
+    return 0;
+  }
+
+  // Someone else may have read the same page meanwhile.
+  old = 0;
+  acquire(&textcache.lock);
+  slot = -1;
+  for(i = 0; i < NTEXTPG; i++){
+    if(textcache.pg[i].mem == 0){
+      if(slot < 0)
+        slot = i;
+    } else if(textcache.pg[i].dev == ip->dev &&
+              textcache.pg[i].inum == ip->inum &&
+              textcache.pg[i].off == off && textcache.pg[i].n == n){
+      old = mem;
+      mem = textcache.pg[i].mem;
+      kref(mem);
+      slot = -1;
+      break;
+    }
+  }
+  if(old == 0){
+    if(slot < 0){
+      slot = textcache.victim;
+      textcache.victim = (textcache.victim + 1) % NTEXTPG;
+      old = textcache.pg[slot].mem;
+    }
+    textcache.pg[slot].dev = ip->dev;
+    textcache.pg[slot].inum = ip->inum;
+    textcache.pg[slot].off = off;
+    textcache.pg[slot].n = n;
+    textcache.pg[slot].mem = mem;
+    kref(mem);  // the cache's reference
+  }
+  release(&textcache.lock);
+  if(old)
+    kfree(old);
+  return mem;
+}
+
+// Drop the stale entries of mapcache and return the page of ip
+// at offset off if some mapping still has it.  Caller holds
+// mapcache.lock.
+static char*
+mapfind(struct inode *ip, uint off)
+{
+  char *mem;
+  int i;
+
+  mem = 0;
+  for(i = 0; i < NMAPPG; i++){
+    if(mapcache.pg[i].mem == 0)
+      continue;
+    if(krefcnt(mapcache.pg[i].mem) == 1){
+      kfree(mapcache.pg[i].mem);
+      mapcache.pg[i].mem = 0;
+    } else if(mapcache.pg[i].dev == ip->dev &&
+              mapcache.pg[i].inum == ip->inum && mapcache.pg[i].off == off)
+      mem = mapcache.pg[i].mem;
+  }
+  return mem;
+}
+
+// Return the page of ip at offset off for a MAP_SHARED mapping:
+// the one its other mappings use, or else a fresh copy.  The
+// caller gets its own reference to the page.
+static char*
+mappage(struct inode *ip, uint off)
+{
+  char *mem, *old;
+  int i;
+
+  acquire(&mapcache.lock);
+  if((mem = mapfind(ip, off)) != 0){
+    kref(mem);
+    release(&mapcache.lock);
+    return mem;
+  }
+  release(&mapcache.lock);
+
+  if((mem = kalloc()) == 0)
+    return 0;
+  memset(mem, 0, PGSIZE);
+  ilock(ip);
+  readi(ip, mem, off, PGSIZE);
+  iunlock(ip);
+
+  // Someone else may have read the same page meanwhile.
+  acquire(&mapcache.lock);
+  if((old = mapfind(ip, off)) != 0){
+    kref(old);
+    release(&mapcache.lock);
+    kfree(mem);
+    return old;
+  }
+  for(i = 0; i < NMAPPG; i++)
+    if(mapcache.pg[i].mem == 0)
+      break;
+  if(i == NMAPPG){
+    release(&mapcache.lock);
+    cprintf("mappage: out of slots\n");
+    kfree(mem);
+    return 0;
+  }
+  mapcache.pg[i].dev = ip->dev;
+  mapcache.pg[i].inum = ip->inum;
+  mapcache.pg[i].off = off;
+  mapcache.pg[i].mem = mem;
+  kref(mem);  // the cache's reference
+  release(&mapcache.lock);
+  return mem;
+}
+
+// Give the current process a private, writable copy of the
+// shared page that pte maps at va.
+static int
+cowpage(pte_t *pte, uint va)
+{
+  uint pa;
+  char *mem;
+
+  pa = PTE_ADDR(*pte);
+  if(krefcnt(P2V(pa)) == 1){
+    // Nobody else has it any more.
+    *pte = (*pte | PTE_W) & ~PTE_COW;
+  } else {
+    if((mem = kalloc()) == 0){
+      cprintf("cowpage out of memory\n");
+      return -1;
+    }
+    memmove(mem, P2V(pa), PGSIZE);
+    *pte = V2P(mem) | ((PTE_FLAGS(*pte) | PTE_W) & ~PTE_COW);
+    kfree(P2V(pa));
+  }
+  invlpg((void*)va);
+  return 0;
+}
+
+// Return the mmap() region of p that holds va, or 0.
+static struct vma*
+findvma(struct proc *p, uint va)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->addr && va >= v->addr && va < v->addr + v->len)
+      return v;
+  return 0;
+}
+
+// Return the end of the part of p's memory that holds va:
+// p->sz for the program image, the end of the region for an
+// mmap() region, or 0 if va is not user memory at all.
+uint
+uvmlimit(struct proc *p, uint va)
+{
+  struct vma *v;
+
+  if(va < p->sz)
+    return p->sz;
+  if((v = findvma(p, va)) != 0)
+    return v->addr + v->len;
+  return 0;
+}
+
+// Fill in the page at va of mmap() region v: file contents,
+// zeroes past the end of the file or for anonymous memory, or
+// the segment's own page for shared memory.  A shared file
+// mapping gets the page every other mapping of it has.
+static int
+vmafault(struct proc *p, struct vma *v, uint va, int write)
+{
+  char *mem;
+  int perm;
+
+  if(write && !(v->prot & PROT_WRITE))
+    return -1;
+  if(!(v->prot & (PROT_READ|PROT_WRITE)))
+    return -1;
+  if(v->shm){
+    if((mem = shmpage(v->shm - 1, (v->off + (va - v->addr)) / PGSIZE)) == 0)
+      return -1;
+  } else if(v->f && (v->flags & MAP_SHARED)){
+    if((mem = mappage(v->f->ip, v->off + (va - v->addr))) == 0)
+      return -1;
+  } else {
+    if((mem = kalloc()) == 0){
+      cprintf("vmafault out of memory\n");
+      return -1;
+    }
+    memset(mem, 0, PGSIZE);
+    if(v->f){
+      ilock(v->f->ip);
+      readi(v->f->ip, mem, v->off + (va - v->addr), PGSIZE);
+      iunlock(v->f->ip);
+    }
+  }
+  perm = PTE_U;
+  if(v->prot & PROT_WRITE)
+    perm |= PTE_W;
+  if(mappages(p->pgdir, (char*)va, PGSIZE, V2P(mem), perm) < 0){
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+struct vdsotime *vdso;  // the page mapped at VDSOTIME
+
+void
+vdsoinit(void)
+{
+  if((vdso = (struct vdsotime*)kalloc()) == 0)
+    panic("vdsoinit");
+  memset(vdso, 0, PGSIZE);
+  vdso->tsckhz = tsckhz;
+  vdso->tscboot = tscboot;
+}
+
+// Map the vdso.h page at va into p, read-only: the shared
+// time page, or a page of p's own holding its pid.
+static int
+vdsofault(struct proc *p, uint va, int write)
+{
+  char *mem;
+
+  if(write)
+    return -1;
+  if(va == VDSOTIME){
+    mem = (char*)vdso;
+    kref(mem);
+  } else {
+    if((mem = kalloc()) == 0)
+      return -1;
+    memset(mem, 0, PGSIZE);
+    ((struct vdsoproc*)mem)->pid = p->pid;
+  }
+  if(mappages(p->pgdir, (char*)va, PGSIZE, V2P(mem), PTE_U) < 0){
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// Resolve a fault on user address va of process p.  Nothing
+// below p->sz is allocated up front:
+//   - program segments are paged in from the executable,
+//     sharing pages with other processes running it until
+//     someone writes to them;
+//   - the rest (bss, heap reserved by sbrk()) is allocated
+//     and zeroed on first touch.
+// Pages of mmap() regions are filled in by vmafault(), and the
+// vdso.h pages by vdsofault().
+// write says whether the access was a write.  Returns 0 if the
+// page is now mapped, -1 if the access was bad.
+int
+uvmfault(struct proc *p, uint va, int write)
+{
+  int i;
+  uint n;
+  char *mem;
+  pte_t *pte;
+  struct execseg *seg;
+  struct vma *v;
+
+  if(va >= KERNBASE)
+    return -1;
+  va = PGROUNDDOWN(va);
+  v = 0;
+  if(va >= p->sz && va < VDSOBASE && (v = findvma(p, va)) == 0)
+    return -1;
+  if((pte = walkpgdir(p->pgdir, (char*)va, 0)) != 0 && (*pte & PTE_P)){
+    if(write && (*pte & PTE_COW))
+      return cowpage(pte, va);
+    return -1;  // a protection fault
+  }
+  if(va >= VDSOBASE)
+    return vdsofault(p, va, write);
+  if(v)
+    return vmafault(p, v, va, write);
+
+  for(i = 0; i < p->nexecseg && p->exe; i++){
+    seg = &p->execseg[i];
+    if(va < seg->vaddr || va >= seg->vaddr + seg->memsz)
+      continue;
+    if(va - seg->vaddr >= seg->filesz)
+      break;  // all bss
+    n = seg->filesz - (va - seg->vaddr);
+    if(n > PGSIZE)
+      n = PGSIZE;
+    if((mem = textpage(p->exe, seg->off + (va - seg->vaddr), n)) == 0)
+      return -1;
+    if(mappages(p->pgdir, (char*)va, PGSIZE, V2P(mem), PTE_U|PTE_COW) < 0){
+      kfree(mem);
+      return -1;
+    }
+    if(write)
+      return cowpage(walkpgdir(p->pgdir, (char*)va, 0), va);
+    return 0;
+  }
+
+  if((mem = kalloc()) == 0){
+    cprintf("uvmfault out of memory\n");
+    return -1;
+  }
+  memset(mem, 0, PGSIZE);
+  if(mappages(p->pgdir, (char*)va, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
+    cprintf("uvmfault out of memory (2)\n");
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// Make sure user addresses [va, va+len) of p are backed by
+// pages, faulting in any that are missing.  Called before the
+// kernel reads or writes user memory on a process's behalf;
+// if write is set, the pages must also be writable, so shared
+// pages are copied and read-only mappings are refused, and the
+// pages are marked dirty so that a shared file mapping writes
+// them back.
+int
+uvmtouch(struct proc *p, uint va, uint len, int write)
+{
+  uint a, last;
+  pte_t *pte;
+
+  if(len == 0)
+    return 0;
+  a = PGROUNDDOWN(va);
+  last = PGROUNDDOWN(va + len - 1);
+  for(;;){
+    pte = walkpgdir(p->pgdir, (char*)a, 0);
+    if((pte == 0 || (*pte & PTE_P) == 0 || (write && !(*pte & PTE_W))) &&
+       (uvmfault(p, a, write) < 0 ||
+        (pte = walkpgdir(p->pgdir, (char*)a, 0)) == 0))
+      return -1;
+    if(write)
+      *pte |= PTE_D;  // the kernel's stores go through P2V
+    if(a == last)
+      break;
+    a += PGSIZE;
+  }
+  return 0;
+}
+
+// Write the page mem, mapped at va in shared region v, back to
+// v's file.  The file does not grow: bytes of the page past its
+// end are dropped.
+static void
+vmawriteback(struct vma *v, uint va, char *mem)
+{
+  int max = ((MAXOPBLOCKS-1-1-2) / 2) * BSIZE;
+  struct inode *ip = v->f->ip;
+  uint off, n, n1, i;
+
+  off = v->off + (va - v->addr);
+  ilock(ip);
+  n = ip->size > off ? ip->size - off : 0;
+  iunlock(ip);
+  if(n > PGSIZE)
+    n = PGSIZE;
+  // Split into transactions small enough for the log,
+  // as filewrite() does.
+  for(i = 0; i < n; i += n1){
+    n1 = n - i;
+    if(n1 > max)
+      n1 = max;
+    begin_op();
+    ilock(ip);
+    writei(ip, mem + i, off + i, n1);
+    iunlock(ip);
+    end_op();
+  }
+}
+
+// Return a region of p overlapping [a, a+len), or 0.
+static struct vma*
+vmaoverlap(struct proc *p, uint a, uint len)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->addr && a < v->addr + v->len && v->addr < a + len)
+      return v;
+  return 0;
+}
+
+// Claim a free region slot of p for len bytes, at addr if that
+// is free, otherwise anywhere above MMAPBASE.  The caller fills
+// in the rest of the slot.
+static struct vma*
+vmaalloc(struct proc *p, uint addr, uint len)
+{
+  struct vma *v, *nv;
+  uint a;
+
+  len = PGROUNDUP(len);
+  if(len == 0 || len > VDSOBASE - MMAPBASE)
+    return 0;
+  nv = 0;
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->addr == 0){
+      nv = v;
+      break;
+    }
+  if(nv == 0)
+    return 0;
+
+  // The caller's hint if it is free, else first fit.
+  a = MMAPBASE;
+  if(addr % PGSIZE == 0 && addr >= MMAPBASE && addr <= VDSOBASE - len &&
+     vmaoverlap(p, addr, len) == 0)
+    a = addr;
+  while((v = vmaoverlap(p, a, len)) != 0){
+    a = v->addr + v->len;
+    if(a > VDSOBASE - len)
+      return 0;
+  }
+
+  nv->addr = a;
+  nv->len = len;
+  nv->f = 0;
+  nv->shm = 0;
+  return nv;
+}
+
+// Map len bytes of f starting at offset off, or zeroes if f is
+// 0, into the current process, at addr if that is free.
+// Nothing is read until the pages are touched.  Returns the
+// address, or -1.
+int
+mmap(uint addr, uint len, int prot, int flags, struct file *f, uint off)
+{
+  struct vma *nv;
+
+  if(len == 0 || off % PGSIZE != 0)
+    return -1;
+  if((nv = vmaalloc(myproc(), addr, len)) == 0)
+    return -1;
+  nv->prot = prot;
+  nv->flags = flags;
+  nv->f = f ? filedup(f) : 0;
+  nv->off = off;
+  return nv->addr;
+}
+
+// Map shared-memory segment id into the current process.
+// Returns the address, or -1.
+int
+shmattach(int id)
+{
+  struct vma *nv;
+  uint len;
+
+  if((len = shmsize(id)) == 0)
+    return -1;
+  if((nv = vmaalloc(myproc(), 0, len)) == 0)
+    return -1;
+  nv->prot = PROT_READ|PROT_WRITE;
+  nv->flags = MAP_SHARED;
+  nv->off = 0;
+  nv->shm = id + 1;
+  shmdup(id);
+  return nv->addr;
+}
+
+// Unmap the shared-memory region starting at addr.
+int
+shmdetach(uint addr)
+{
+  struct vma *v;
+
+  if((v = findvma(myproc(), addr)) == 0 || v->addr != addr || v->shm == 0)
+    return -1;
+  return munmap(v->addr, v->len);
+}
+
+// Drop the pages of [lo, hi) in region v of p, writing back the
+// ones a shared file mapping has dirtied.
+static void
+vmaunmap(struct proc *p, struct vma *v, uint lo, uint hi)
+{
+  pte_t *pte;
+  char *mem;
+  uint a;
+
+  for(a = lo; a < hi; a += PGSIZE){
+    if((pte = walkpgdir(p->pgdir, (char*)a, 0)) == 0){
+      a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
+      continue;
+    }
+    if(!(*pte & PTE_P))
+      continue;
+    mem = P2V(PTE_ADDR(*pte));
+    if(v->f && (v->flags & MAP_SHARED) && (*pte & PTE_D))
+      vmawriteback(v, a, mem);
+    *pte = 0;
+    kfree(mem);
+  }
+}
+
+// Remove the mmap() regions of the current process in
+// [addr, addr+len), which may cut regions in two.
+int
+munmap(uint addr, uint len)
+{
+  struct proc *p = myproc();
+  struct vma *v, *nv;
+  uint end, vend, lo, hi;
+
+  len = PGROUNDUP(len);
+  end = addr + len;
+  if(addr % PGSIZE != 0 || end < addr || addr < MMAPBASE || end > VDSOBASE)
+    return -1;
+
+  // Find a spare slot first in case a region is split.
+  nv = 0;
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->addr == 0){
+      nv = v;
+      break;
+    }
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->addr && addr > v->addr && end < v->addr + v->len && nv == 0)
+      return -1;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->addr == 0 || v == nv)
+      continue;
+    vend = v->addr + v->len;
+    if(end <= v->addr || addr >= vend)
+      continue;
+    lo = addr > v->addr ? addr : v->addr;
+    hi = end < vend ? end : vend;
+    vmaunmap(p, v, lo, hi);
+    if(lo == v->addr && hi == vend){
+      if(v->f)
+        fileclose(v->f);
+      if(v->shm)
+        shmclose(v->shm - 1);
+      v->addr = 0;
+      v->f = 0;
+      v->shm = 0;
+    } else if(lo == v->addr){
+      v->off += hi - v->addr;
+      v->len = vend - hi;
+      v->addr = hi;
+    } else if(hi == vend){
+      v->len = lo - v->addr;
+    } else {
+      *nv = *v;
+      nv->addr = hi;
+      nv->len = vend - hi;
+      nv->off = v->off + (hi - v->addr);
+      if(nv->f)
+        filedup(nv->f);
+      if(nv->shm)
+        shmdup(nv->shm - 1);
+      v->len = lo - v->addr;
+    }
+  }
+  lcr3(V2P(p->pgdir));
+  return 0;
+}
+
+// Give child np the mmap() regions of the current process.
+// Shared regions share their pages, so the parent pages them
+// all in first; private regions get copies of what it has.
+int
+vmacopy(struct proc *np)
+{
+  struct proc *p = myproc();
+  struct vma *v;
+  pte_t *pte;
+  uint a, pa, flags;
+  char *mem;
+  int i;
+
+  for(i = 0; i < NVMA; i++){
+    v = &p->vma[i];
+    if(v->addr == 0)
+      continue;
+    np->vma[i] = *v;
+    if(v->f)
+      filedup(v->f);
+    if(v->shm)
+      shmdup(v->shm - 1);
+    for(a = v->addr; a < v->addr + v->len; a += PGSIZE){
+      pte = walkpgdir(p->pgdir, (char*)a, 0);
+      if((pte == 0 || !(*pte & PTE_P)) && (v->flags & MAP_SHARED)){
+        if(vmafault(p, v, a, 0) < 0)
+          goto bad;
+        pte = walkpgdir(p->pgdir, (char*)a, 0);
+      }
+      if(pte == 0 || !(*pte & PTE_P))
+        continue;
+      pa = PTE_ADDR(*pte);
+      flags = PTE_FLAGS(*pte);
+      if(v->flags & MAP_SHARED){
+        // Both sides keep the dirty bit: the page is the same,
+        // and whichever unmaps first must not drop the write.
+        if(mappages(np->pgdir, (char*)a, PGSIZE, pa, flags) < 0)
+          goto bad;
+        kref(P2V(pa));
+        continue;
+      }
+      if((mem = kalloc()) == 0)
+        goto bad;
+      memmove(mem, P2V(pa), PGSIZE);
+      if(mappages(np->pgdir, (char*)a, PGSIZE, V2P(mem), flags & ~PTE_D) < 0){
+        kfree(mem);
+        goto bad;
+      }
+    }
+  }
+  return 0;
+
+bad:
+  // The caller frees np's page table and the pages with it.
+  for(v = np->vma; v < &np->vma[NVMA]; v++){
+    if(v->addr && v->f)
+      fileclose(v->f);
+    if(v->addr && v->shm)
+      shmclose(v->shm - 1);
+    v->addr = 0;
+    v->f = 0;
+    v->shm = 0;
+  }
+  return -1;
+}
+
 //PAGEBREAK!
 // Map user virtual address to kernel address.
 char*
@@ -351,8 +1151,10 @@ uva2ka(pde_t *pgdir, char *uva)
 {
   pte_t *pte;
 
+  if((uint)uva >= KERNBASE)
+    return 0;
   pte = walkpgdir(pgdir, uva, 0);
-  if((*pte & PTE_P) == 0)
+  if(pte == 0 || (*pte & PTE_P) == 0)
     return 0;
   if((*pte & PTE_U) == 0)
     return 0;
@@ -367,13 +1169,25 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
 {
   char *buf, *pa0;
   uint n, va0;
+  pte_t *pte;
 
+  if(va >= KERNBASE || va + len < va || va + len > KERNBASE)
+    return -1;
   buf = (char*)p;
   while(len > 0){
     va0 = (uint)PGROUNDDOWN(va);
+    // The current process may not have the page yet, or may
+    // share it with others; either way, fault in a private copy
+    // rather than writing through the kernel's mapping.
+    pte = walkpgdir(pgdir, (char*)va0, 0);
+    if((pte == 0 || (*pte & (PTE_P|PTE_W)) != (PTE_P|PTE_W)) &&
+       myproc() && pgdir == myproc()->pgdir &&
+       uvmfault(myproc(), va0, 1) < 0)
+      return -1;
     pa0 = uva2ka(pgdir, (char*)va0);
     if(pa0 == 0)
       return -1;
+    *walkpgdir(pgdir, (char*)va0, 0) |= PTE_D;  // see uvmtouch()
     n = PGSIZE - (va - va0);
     if(n > len)
       n = len;
@@ -0,0 +1,34 @@
+// An RR process sleeps one tick at a time while FCFS hogs keep
+// every CPU busy.  If it is woken promptly, N sleeps take about
+// N ticks; waiting out the hogs' turns makes it much longer.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NHOG 4
+#define N    100
+
+int
+main(void)
+{
+  int i, pid[NHOG], start;
+
+  for(i = 0; i < NHOG; i++){
+    if((pid[i] = fork()) == 0)
+      for(;;)
+        ;
+  }
+
+  change_queue(getpid(), 0);  // RR
+  start = uptime();
+  for(i = 0; i < N; i++)
+    sleep(1);
+  printf(1, "wakebench: %d one-tick sleeps took %d ticks\n", N, uptime() - start);
+
+  for(i = 0; i < NHOG; i++){
+    kill(pid[i]);
+    wait();
+  }
+  exit();
+}
@@ -117,6 +117,38 @@ sti(void)
   asm volatile("sti");
 }
 
+// Wait for an interrupt.  Right after sti(), the two together
+// cannot miss an interrupt that arrives in between.
+static inline void
+hlt(void)
+{
+  asm volatile("hlt");
+}
+
+// Read the time-stamp counter.
+static inline uint64
+rdtsc(void)
+{
+  uint64 t;
+
+  asm volatile("rdtsc" : "=A" (t));
+  return t;
+}
+
+// Return n / d, and n % d in *rem if rem is non-zero.
+// The quotient must fit in 32 bits.
+static inline uint
+divq(uint64 n, uint d, uint *rem)
+{
+  uint q, r;
+
+  asm("divl %4" : "=a" (q), "=d" (r) : "a" ((uint)n), "d" ((uint)(n >> 32)),
+      "rm" (d));
+  if(rem)
+    *rem = r;
+  return q;
+}
+
 static inline uint
 xchg(volatile uint *addr, uint newval)
 {
@@ -138,12 +170,24 @@ rcr2(void)
   return val;
 }
 
+static inline void
+wrmsr(uint msr, uint64 val)
+{
+  asm volatile("wrmsr" : : "c" (msr), "A" (val));
+}
+
 static inline void
 lcr3(uint val)
 {
   asm volatile("movl %0,%%cr3" : : "r" (val));
 }
 
+static inline void
+invlpg(void *addr)
+{
+  asm volatile("invlpg (%0)" : : "r" (addr) : "memory");
+}
+
 //PAGEBREAK: 36
 // Layout of the trap frame built on the stack by the
 // hardware and by trapasm.S, and passed to trap().
@@ -0,0 +1,32 @@
+// Two RR processes yield the CPU back and forth.  On one CPU
+// every yield is a switch to the other process.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+
+#define N 10000
+
+int
+main(void)
+{
+  int i, pid;
+  uint64 start;
+  uint us;
+
+  change_queue(getpid(), 0);  // RR
+  start = nsec();
+  pid = fork();
+  if(pid == 0)
+    change_queue(getpid(), 0);
+  for(i = 0; i < N; i++)
+    yield();
+  if(pid == 0)
+    exit();
+  wait();
+  us = usecsince(start);
+  printf(1, "yieldbench: 2x%d yields in %d us, %d ns each\n",
+         N, us, divq((uint64)us * 1000, 2*N, 0));
+  exit();
+}